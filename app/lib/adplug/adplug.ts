@@ -5,6 +5,11 @@
  * using the AdPlug library compiled to WebAssembly.
  */
 
+import { loadEmscriptenFactory } from "../emscripten-loader";
+import { readRenderStats, type RenderStats } from "../render-stats";
+import { readPlaybackSnapshot, type PlaybackSnapshot } from "../playback-state";
+import { readPatternChanges, type PatternChange } from "../pattern-state";
+
 // Types for Emscripten module
 interface AdPlugEmscriptenModule {
   _malloc(size: number): number;
@@ -28,6 +33,34 @@ interface AdPlugEmscriptenModule {
   _emu_get_refresh_rate(): number;
   _emu_set_loop_enabled(enabled: number): void;
   _emu_get_loop_enabled(): number;
+  // Optional: missing from binaries built before these adapter features
+  // (call through ?. so older public/adplug.wasm builds keep playing)
+  _emu_render_overview?(buckets: number): number;
+  _emu_get_overview_buffer?(): number;
+  _emu_get_overview_buckets?(): number;
+  _emu_set_cue_rate?(rate: number): void;
+  _emu_get_cue_rate?(): number;
+  _emu_set_loop_cache_budget?(bytes: number): void;
+  _emu_is_loop_cache_playing?(): number;
+  _emu_export_begin?(stems: number): number;
+  _emu_export_render?(maxFrames: number): number;
+  _emu_export_get_buffer?(): number;
+  _emu_export_get_length?(): number;
+  _emu_export_end?(): void;
+  _emu_trace_enable?(capacity: number): void;
+  _emu_trace_clear?(): void;
+  _emu_trace_export?(): number;
+  _emu_stats_get?(): number;
+  _emu_stats_reset?(): void;
+  _emu_scope_enable?(decimation: number, frames: number): number;
+  _emu_scope_get_buffer?(): number;
+  _emu_scope_get_written?(): number;
+  _emu_set_stereo_width?(percent: number): void;
+  _emu_set_adaptive_quality?(enabled: number): void;
+  _emu_set_quality_level?(level: number): void;
+  _emu_get_quality_level?(): number;
+  _emu_get_state_block?(): number;
+  _emu_get_pattern_state?(): number;
 
   HEAP8: Int8Array;
   HEAP16: Int16Array;
@@ -35,6 +68,7 @@ interface AdPlugEmscriptenModule {
   HEAPU8: Uint8Array;
   HEAPU16: Uint16Array;
   HEAPU32: Uint32Array;
+  HEAPF32: Float32Array;
 
   UTF8ToString(ptr: number): string;
   stringToUTF8(str: string, outPtr: number, maxBytesToWrite: number): void;
@@ -57,6 +91,21 @@ export interface PlaybackState {
   trackInfo: TrackInfo;
 }
 
+/**
+ * Seek-bar waveform envelope for the whole song
+ * Cache it together with durationMs - both depend only on the file and subsong
+ */
+export interface WaveformOverview {
+  buckets: number;
+  min: Float32Array;  // -1.0 ~ 0.0
+  max: Float32Array;  // 0.0 ~ 1.0
+  rms: Float32Array;  // 0.0 ~ 1.0
+  durationMs: number;
+}
+
+// Frames rendered per export call (large calls keep per-call overhead negligible)
+const EXPORT_CHUNK_FRAMES = 65536;
+
 // Module loader cache
 let modulePromise: Promise<AdPlugEmscriptenModule> | null = null;
 // Track if emulator has been initialized at least once (to know if teardown is needed)
@@ -70,42 +119,20 @@ async function loadModule(): Promise<AdPlugEmscriptenModule> {
     return modulePromise;
   }
 
-  modulePromise = new Promise(async (resolve, reject) => {
-    try {
-      // Load the Emscripten JS file dynamically
-      const script = document.createElement('script');
-      script.src = '/adplug.js';
+  modulePromise = (async () => {
+    // Load the Emscripten JS file (script tag on main thread, eval in workers)
+    const factory = await loadEmscriptenFactory('/adplug.js', 'AdPlugModule');
 
-      script.onload = async () => {
-        // AdPlugModule should be available globally after script loads
-        const AdPlugModule = (window as any).AdPlugModule;
-        if (!AdPlugModule) {
-          reject(new Error('AdPlugModule not found after script load'));
-          return;
+    // Initialize the module
+    return factory({
+      locateFile: (path: string) => {
+        if (path.endsWith('.wasm')) {
+          return '/adplug.wasm';
         }
-
-        // Initialize the module
-        const module = await AdPlugModule({
-          locateFile: (path: string) => {
-            if (path.endsWith('.wasm')) {
-              return '/adplug.wasm';
-            }
-            return path;
-          }
-        });
-
-        resolve(module);
-      };
-
-      script.onerror = () => {
-        reject(new Error('Failed to load adplug.js'));
-      };
-
-      document.head.appendChild(script);
-    } catch (err) {
-      reject(err);
-    }
-  });
+        return path;
+      }
+    }) as Promise<AdPlugEmscriptenModule>;
+  })();
 
   return modulePromise;
 }
@@ -121,6 +148,8 @@ export class AdPlugPlayer {
   private currentSubsong = 0;
   private sampleRate = 49716;
   private fileLoaded = false;
+  private scopeFrames = 0;
+  private scopeDecimation = 1;
 
   /**
    * Initialize the player with specified sample rate
@@ -377,6 +406,263 @@ export class AdPlugPlayer {
     return this.module._emu_get_loop_enabled() !== 0;
   }
 
+  /**
+   * Set fast-forward cue rate (1 = normal, 2-16 = audible fast-forward)
+   * Content advances at the given multiple while only short snippets are synthesized
+   */
+  setCueRate(rate: number): void {
+    this.module?._emu_set_cue_rate?.(Math.round(rate));
+  }
+
+  /**
+   * Get fast-forward cue rate
+   */
+  getCueRate(): number {
+    return this.module?._emu_get_cue_rate?.() ?? 1;
+  }
+
+  /**
+   * Set memory budget for the loop cache (0 = disabled)
+   * A full pass from the start of the song is kept as PCM if it fits,
+   * so later loops and rewinds stream from memory instead of resynthesizing
+   */
+  setLoopCacheBudget(bytes: number): void {
+    this.module?._emu_set_loop_cache_budget?.(Math.max(0, Math.floor(bytes)));
+  }
+
+  /**
+   * Check whether playback is currently streaming from the loop cache
+   */
+  isLoopCachePlaying(): boolean {
+    if (!this.module?._emu_is_loop_cache_playing || !this.fileLoaded) {
+      return false;
+    }
+    return this.module._emu_is_loop_cache_playing() !== 0;
+  }
+
+  /**
+   * Read the state block published by the last render call
+   * (position, tick, row, channel levels, loop count) without calling into the engine
+   */
+  getPlaybackSnapshot(): PlaybackSnapshot | null {
+    if (!this.module?._emu_get_state_block) {
+      return null;
+    }
+    return readPlaybackSnapshot(this.module.HEAPU8.buffer, this.module._emu_get_state_block());
+  }
+
+  /**
+   * Pattern position changes during the last generateSamples() call,
+   * with frame offsets into the block (empty for formats without patterns)
+   */
+  getPatternChanges(): PatternChange[] {
+    if (!this.module?._emu_get_pattern_state) {
+      return [];
+    }
+    return readPatternChanges(this.module.HEAP32, this.module._emu_get_pattern_state());
+  }
+
+  /**
+   * Capture per-channel oscilloscope data during synthesis
+   * @param decimation Output samples per captured frame (1-64), e.g. 8 for 1/8 rate
+   * @param frames Ring capacity in frames; 0 stops capture and frees the ring
+   */
+  setScopeCapture(decimation: number, frames: number): boolean {
+    if (!this.module?._emu_scope_enable) {
+      return false;
+    }
+    const ok = this.module._emu_scope_enable(Math.floor(decimation), Math.floor(frames)) === 0;
+    if (ok) {
+      this.scopeFrames = Math.floor(frames);
+      this.scopeDecimation = Math.floor(decimation);
+    }
+    return ok;
+  }
+
+  /**
+   * Sample rate of the captured scope frames
+   */
+  getScopeSampleRate(): number {
+    return this.sampleRate / this.scopeDecimation;
+  }
+
+  /**
+   * Copy the most recent scope frames, oldest first
+   * Layout: count frames of 18 interleaved int16 values (one per OPL channel)
+   * @param count Frames to read (at most the ring capacity)
+   */
+  readScope(count: number): Int16Array | null {
+    if (!this.module?._emu_scope_get_buffer || !this.module._emu_scope_get_written || this.scopeFrames === 0) {
+      return null;
+    }
+    const ptr = this.module._emu_scope_get_buffer();
+    if (ptr === 0) {
+      return null;
+    }
+
+    const channels = 18;
+    const written = this.module._emu_scope_get_written() >>> 0;
+    const frames = Math.min(Math.floor(count), this.scopeFrames, written);
+    const ring = this.module.HEAP16.subarray(ptr / 2, ptr / 2 + this.scopeFrames * channels);
+    const out = new Int16Array(frames * channels);
+
+    // Oldest requested frame, then up to two contiguous copies around the wrap
+    const start = (written - frames) % this.scopeFrames;
+    const first = Math.min(frames, this.scopeFrames - start);
+    out.set(ring.subarray(start * channels, (start + first) * channels), 0);
+    out.set(ring.subarray(0, (frames - first) * channels), first * channels);
+    return out;
+  }
+
+  /**
+   * Location of the state block, for readers on other threads
+   * Only useful across threads when the module memory is a SharedArrayBuffer
+   */
+  getStateBlock(): { buffer: ArrayBufferLike; ptr: number } | null {
+    if (!this.module?._emu_get_state_block) {
+      return null;
+    }
+    return { buffer: this.module.HEAPU8.buffer, ptr: this.module._emu_get_state_block() };
+  }
+
+  /**
+   * Get render deadline statistics (render time vs. duration of the audio produced)
+   */
+  getRenderStats(): RenderStats | null {
+    if (!this.module?._emu_stats_get) {
+      return null;
+    }
+    return readRenderStats(this.module.HEAPU32, this.module._emu_stats_get());
+  }
+
+  /**
+   * Reset render deadline statistics (e.g. per reporting interval)
+   */
+  resetRenderStats(): void {
+    this.module?._emu_stats_reset?.();
+  }
+
+  /**
+   * Pseudo-stereo for mono OPL2 songs: pans channels across the field from one chip
+   * @param percent 0 = off (mono chip mix) .. 100 = widest
+   */
+  setStereoWidth(percent: number): void {
+    this.module?._emu_set_stereo_width?.(Math.round(percent));
+  }
+
+  /**
+   * Let render cost drive synthesis quality
+   * Under sustained load: nearest resampling, then the OPL2 core, then the fast OPL3 core;
+   * quality returns after a few seconds of headroom
+   */
+  setAdaptiveQuality(enabled: boolean): void {
+    this.module?._emu_set_adaptive_quality?.(enabled ? 1 : 0);
+  }
+
+  /**
+   * Force a quality level (0 = full quality .. 3 = fast OPL3 core)
+   */
+  setQualityLevel(level: number): void {
+    this.module?._emu_set_quality_level?.(Math.max(0, Math.floor(level)));
+  }
+
+  /**
+   * Get the current quality level (0 = full quality)
+   */
+  getQualityLevel(): number {
+    return this.module?._emu_get_quality_level?.() ?? 0;
+  }
+
+  /**
+   * Record the render timeline (render calls, player ticks, OPL runs, loads, seeks)
+   * @param capacity Number of spans kept, oldest dropped first; 0 stops and frees the ring
+   */
+  setTraceCapacity(capacity: number): void {
+    this.module?._emu_trace_enable?.(Math.max(0, Math.floor(capacity)));
+  }
+
+  /**
+   * Export recorded spans as Chrome trace-event JSON (open in Perfetto)
+   */
+  exportTrace(): string | null {
+    if (!this.module?._emu_trace_export) {
+      return null;
+    }
+    return this.module.UTF8ToString(this.module._emu_trace_export());
+  }
+
+  /**
+   * Render the whole song to a 16-bit stereo WAV file as fast as possible
+   * Blocks until done - call it from a Web Worker with its own module instance
+   * @param onProgress Called with progress 0.0 ~ 1.0 after each render chunk
+   * @param stems Write one WAV channel per OPL channel (18 channels) instead of the stereo mix
+   */
+  exportWav(onProgress?: (progress: number) => void, stems = false): Uint8Array | null {
+    const module = this.module;
+    if (!module || !this.fileLoaded || !module._emu_export_begin || !module._emu_export_render ||
+        !module._emu_export_get_buffer || !module._emu_export_get_length || !module._emu_export_end) {
+      return null;
+    }
+
+    if (module._emu_export_begin(stems ? 1 : 0) !== 0) {
+      return null;
+    }
+
+    let result = 0;
+    while (result >= 0 && result < 1000) {
+      result = module._emu_export_render(EXPORT_CHUNK_FRAMES);
+      if (onProgress && result >= 0) {
+        onProgress(result / 1000);
+      }
+    }
+
+    let wav: Uint8Array | null = null;
+    if (result === 1000) {
+      const ptr = module._emu_export_get_buffer();
+      const length = module._emu_export_get_length();
+      wav = module.HEAPU8.slice(ptr, ptr + length);
+    }
+
+    module._emu_export_end();
+    return wav;
+  }
+
+  /**
+   * Render a min/max/RMS envelope of the whole song for the seek bar
+   * Uses a separate low-rate analysis pass, so playback state is not affected
+   * Blocks for the whole pass - call it from a Web Worker with its own module
+   * instance (BatchPool.renderOverview), not on the playback thread
+   */
+  renderOverview(buckets: number): WaveformOverview | null {
+    const module = this.module;
+    if (!module || !this.fileLoaded || !module._emu_render_overview ||
+        !module._emu_get_overview_buckets || !module._emu_get_overview_buffer) {
+      return null;
+    }
+
+    if (module._emu_render_overview(buckets) !== 0) {
+      return null;
+    }
+
+    const count = module._emu_get_overview_buckets();
+    const start = module._emu_get_overview_buffer() / 4; // byte offset to float32 offset
+    const data = module.HEAPF32.subarray(start, start + count * 3);
+
+    const overview: WaveformOverview = {
+      buckets: count,
+      min: new Float32Array(count),
+      max: new Float32Array(count),
+      rms: new Float32Array(count),
+      durationMs: module._emu_get_max_position(),
+    };
+    for (let i = 0; i < count; i++) {
+      overview.min[i] = data[i * 3];
+      overview.max[i] = data[i * 3 + 1];
+      overview.rms[i] = data[i * 3 + 2];
+    }
+    return overview;
+  }
+
   /**
    * Clean up resources
    */
@@ -0,0 +1,47 @@
+/**
+ * emscripten-loader.ts - Emscripten MODULARIZE 스크립트 로더
+ *
+ * 메인 스레드에서는 <script> 태그로, Web Worker에서는 fetch + 전역 eval로
+ * 스크립트를 실행한 뒤 전역에 정의된 모듈 팩토리 함수를 반환합니다.
+ * 워커마다 독립된 WASM 인스턴스를 만들 수 있도록 하기 위함입니다.
+ */
+
+// eslint-disable-next-line @typescript-eslint/no-explicit-any
+type EmscriptenFactory = (options: Record<string, unknown>) => Promise<any>;
+
+/**
+ * Emscripten 스크립트를 로드하고 팩토리 함수를 반환
+ * @param src 스크립트 URL (예: '/adplug.js')
+ * @param exportName EXPORT_NAME으로 지정된 전역 이름 (예: 'AdPlugModule')
+ */
+export async function loadEmscriptenFactory(src: string, exportName: string): Promise<EmscriptenFactory> {
+  // eslint-disable-next-line @typescript-eslint/no-explicit-any
+  const scope = globalThis as any;
+
+  if (typeof document === 'undefined') {
+    // Worker: 모듈 워커에서는 importScripts를 쓸 수 없으므로 전역 스코프에서 직접 실행
+    if (!scope[exportName]) {
+      const response = await fetch(src);
+      if (!response.ok) {
+        throw new Error(`Failed to load ${src}`);
+      }
+      const code = await response.text();
+      // 간접 eval은 전역 스코프에서 실행되므로 var 선언이 전역 객체에 등록됨
+      (0, eval)(`${code}\n;self[${JSON.stringify(exportName)}] = ${exportName};`);
+    }
+  } else if (!scope[exportName]) {
+    await new Promise<void>((resolve, reject) => {
+      const script = document.createElement('script');
+      script.src = src;
+      script.onload = () => resolve();
+      script.onerror = () => reject(new Error(`Failed to load ${src}`));
+      document.head.appendChild(script);
+    });
+  }
+
+  const factory = scope[exportName];
+  if (!factory) {
+    throw new Error(`${exportName} not found after script load`);
+  }
+  return factory;
+}
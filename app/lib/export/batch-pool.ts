@@ -0,0 +1,254 @@
+/**
+ * batch-pool.ts - 브라우저 배치 작업용 워커 풀
+ *
+ * navigator.hardwareConcurrency 개수만큼 export 워커를 띄우고,
+ * 각 워커는 자기 WASM 모듈 인스턴스로 공유 큐에서 작업을 하나씩 가져갑니다.
+ * 폴더 스캔, 라우드니스 분석, 탐색 막대 엔벨로프, 여러 곡 WAV 내보내기를 메인 스레드
+ * 재생과 별개로 병렬 처리합니다. 결과 버퍼는 transferable로 복사 없이 돌아옵니다.
+ *
+ * 사용 예:
+ *   const pool = new BatchPool();
+ *   const results = await Promise.all(files.map((file) => pool.scan(file)));
+ *   pool.dispose();
+ */
+
+import type {
+  BatchJobKind,
+  ExportRequest,
+  ExportResponse,
+  LoudnessResult,
+  OverviewResult,
+  ScanResult,
+} from "./export.worker";
+
+export type { LoudnessResult, OverviewResult, ScanResult };
+
+const BATCH_SAMPLE_RATE = 44100;
+// 워커마다 WASM 메모리를 따로 가지므로 코어가 많아도 이 개수까지만 사용
+const MAX_POOL_WORKERS = 8;
+
+interface BatchJob {
+  kind: BatchJobKind;
+  file: File;
+  bnkFile: File | null;
+  stems?: boolean;
+  buckets?: number;
+  onProgress?: (progress: number) => void;
+  resolve: (response: ExportResponse) => void;
+  reject: (error: Error) => void;
+}
+
+interface PoolWorker {
+  worker: Worker;
+  job: BatchJob | null;
+}
+
+/**
+ * 기본 워커 수 (하드웨어 스레드 수, 최대 MAX_POOL_WORKERS)
+ */
+export function defaultPoolSize(): number {
+  const cores = typeof navigator !== 'undefined' ? navigator.hardwareConcurrency || 2 : 2;
+  return Math.max(1, Math.min(cores, MAX_POOL_WORKERS));
+}
+
+export class BatchPool {
+  private readonly size: number;
+  private readonly workers: PoolWorker[] = [];
+  private readonly queue: BatchJob[] = [];
+  private nextId = 1;
+  private disposed = false;
+
+  /**
+   * @param size 워커 수 (기본값: defaultPoolSize())
+   */
+  constructor(size = defaultPoolSize()) {
+    this.size = Math.max(1, Math.floor(size));
+  }
+
+  /**
+   * 재생 없이 로드만 해서 메타데이터와 길이를 읽음 (폴더 스캔용)
+   */
+  async scan(file: File, bnkFile: File | null = null): Promise<ScanResult> {
+    const response = await this.submit({ kind: 'scan', file, bnkFile });
+    if (response.type !== 'scan') {
+      throw new Error("Unexpected scan response");
+    }
+    return response.result;
+  }
+
+  /**
+   * 곡 전체의 피크 / RMS 레벨 분석
+   * @param buckets 엔벨로프 구간 수
+   */
+  async analyzeLoudness(file: File, bnkFile: File | null = null, buckets?: number): Promise<LoudnessResult> {
+    const response = await this.submit({ kind: 'loudness', file, bnkFile, buckets });
+    if (response.type !== 'loudness') {
+      throw new Error("Unexpected loudness response");
+    }
+    return response.result;
+  }
+
+  /**
+   * 탐색 막대용 min/max/RMS 엔벨로프 렌더링
+   * 곡 전체를 분석하는 동기 작업이라 재생 중인 메인 스레드 대신 워커에서 실행
+   * @param buckets 엔벨로프 구간 수
+   */
+  async renderOverview(file: File, bnkFile: File | null = null, buckets?: number): Promise<OverviewResult> {
+    const response = await this.submit({ kind: 'overview', file, bnkFile, buckets });
+    if (response.type !== 'overview') {
+      throw new Error("Unexpected overview response");
+    }
+    return response.result;
+  }
+
+  /**
+   * WAV로 렌더링 (export-wav.ts의 exportToWav와 같은 결과)
+   * @param onProgress 진행률 콜백 (0.0 ~ 1.0)
+   * @param stems true면 채널별 스템 멀티채널 WAV
+   */
+  async exportWav(
+    file: File,
+    bnkFile: File | null = null,
+    onProgress?: (progress: number) => void,
+    stems = false
+  ): Promise<Blob> {
+    const response = await this.submit({ kind: 'export', file, bnkFile, stems, onProgress });
+    if (response.type !== 'done') {
+      throw new Error("Unexpected export response");
+    }
+    return new Blob([response.wav], { type: "audio/wav" });
+  }
+
+  /**
+   * 대기 중인 작업 수 (실행 중인 작업 제외)
+   */
+  getPendingCount(): number {
+    return this.queue.length;
+  }
+
+  /**
+   * 모든 워커 종료, 대기 / 실행 중인 작업은 실패 처리
+   */
+  dispose(): void {
+    this.disposed = true;
+    const error = new Error("Batch pool disposed");
+    for (const pooled of this.workers) {
+      pooled.worker.terminate();
+      pooled.job?.reject(error);
+      pooled.job = null;
+    }
+    this.workers.length = 0;
+    for (const job of this.queue.splice(0)) {
+      job.reject(error);
+    }
+  }
+
+  private submit(
+    job: Omit<BatchJob, 'resolve' | 'reject'>
+  ): Promise<ExportResponse> {
+    if (this.disposed) {
+      return Promise.reject(new Error("Batch pool disposed"));
+    }
+    return new Promise<ExportResponse>((resolve, reject) => {
+      this.queue.push({ ...job, resolve, reject });
+      this.pump();
+    });
+  }
+
+  // 쉬는 워커에 큐의 다음 작업을 배정 (필요하면 워커 생성)
+  private pump(): void {
+    while (this.queue.length > 0) {
+      let pooled = this.workers.find((w) => w.job === null);
+      if (!pooled) {
+        if (this.workers.length >= this.size) {
+          return;
+        }
+        pooled = this.spawnWorker();
+      }
+      const job = this.queue.shift()!;
+      pooled.job = job;
+      void this.dispatch(pooled, job);
+    }
+  }
+
+  private spawnWorker(): PoolWorker {
+    const worker = new Worker(new URL("./export.worker.ts", import.meta.url), { type: "module" });
+    const pooled: PoolWorker = { worker, job: null };
+
+    worker.onerror = (event) => {
+      // 워커 자체가 죽으면 교체하고 실행 중이던 작업만 실패 처리
+      const job = pooled.job;
+      pooled.job = null;
+      worker.terminate();
+      const index = this.workers.indexOf(pooled);
+      if (index >= 0) {
+        this.workers.splice(index, 1);
+      }
+      job?.reject(new Error(event.message || "Batch worker failed"));
+      this.pump();
+    };
+
+    this.workers.push(pooled);
+    return pooled;
+  }
+
+  // 파일은 배정 시점에 읽어서 큐에 쌓인 작업이 메모리를 차지하지 않도록 함
+  private async dispatch(pooled: PoolWorker, job: BatchJob): Promise<void> {
+    let request: ExportRequest;
+    try {
+      const data = new Uint8Array(await job.file.arrayBuffer());
+      const bnkData = job.bnkFile ? new Uint8Array(await job.bnkFile.arrayBuffer()) : undefined;
+      request = {
+        id: this.nextId++,
+        kind: job.kind,
+        filename: job.file.name,
+        data,
+        bnkFilename: job.bnkFile?.name,
+        bnkData,
+        sampleRate: BATCH_SAMPLE_RATE,
+        stems: job.stems,
+        buckets: job.buckets,
+      };
+    } catch (err) {
+      this.finish(pooled);
+      job.reject(err instanceof Error ? err : new Error("Failed to read file"));
+      return;
+    }
+
+    if (pooled.job !== job) {
+      // 파일을 읽는 동안 dispose 또는 워커 오류로 취소됨
+      return;
+    }
+
+    pooled.worker.onmessage = (event: MessageEvent<ExportResponse>) => {
+      const response = event.data;
+      if (response.id !== request.id) {
+        return;
+      }
+      if (response.type === 'progress') {
+        job.onProgress?.(response.progress);
+        return;
+      }
+      this.finish(pooled);
+      if (response.type === 'error') {
+        job.reject(new Error(response.message));
+      } else {
+        job.resolve(response);
+      }
+    };
+
+    const transfer: Transferable[] = [request.data.buffer as ArrayBuffer];
+    if (request.bnkData) {
+      transfer.push(request.bnkData.buffer as ArrayBuffer);
+    }
+    pooled.worker.postMessage(request, transfer);
+  }
+
+  // 워커를 쉬는 상태로 돌리고 다음 작업 배정
+  private finish(pooled: PoolWorker): void {
+    pooled.job = null;
+    if (!this.disposed) {
+      this.pump();
+    }
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * export-wav.ts - 오프라인 WAV 내보내기 API
+ *
+ * 전용 Web Worker에서 곡 전체를 실시간보다 빠르게 렌더링합니다.
+ * MediaStream 실시간 녹음 없이 AdPlug / libopenmpt 곡을 모두 WAV로 저장할 수 있습니다.
+ */
+
+import type { ExportRequest, ExportResponse } from "./export.worker";
+
+const EXPORT_SAMPLE_RATE = 44100;
+
+/**
+ * 음악 파일을 WAV Blob으로 렌더링
+ * @param musicFile 음악 파일
+ * @param bnkFile BNK 악기 파일 (IMS/ROL, 없으면 null)
+ * @param onProgress 진행률 콜백 (0.0 ~ 1.0)
+ * @param stems true면 채널별 스템을 하나의 멀티채널 WAV로 출력 (OPL 18채널 / 트래커 채널 수)
+ */
+export async function exportToWav(
+  musicFile: File,
+  bnkFile: File | null,
+  onProgress?: (progress: number) => void,
+  stems = false
+): Promise<Blob> {
+  const data = new Uint8Array(await musicFile.arrayBuffer());
+  const bnkData = bnkFile ? new Uint8Array(await bnkFile.arrayBuffer()) : undefined;
+
+  const worker = new Worker(new URL("./export.worker.ts", import.meta.url), { type: "module" });
+
+  try {
+    const wav = await new Promise<ArrayBuffer>((resolve, reject) => {
+      worker.onmessage = (event: MessageEvent<ExportResponse>) => {
+        const response = event.data;
+        if (response.type === 'progress') {
+          onProgress?.(response.progress);
+        } else if (response.type === 'done') {
+          resolve(response.wav);
+        } else {
+          reject(new Error(response.message));
+        }
+      };
+      worker.onerror = (event) => {
+        reject(new Error(event.message || "Export worker failed"));
+      };
+
+      const request: ExportRequest = {
+        id: 0,
+        filename: musicFile.name,
+        data,
+        bnkFilename: bnkFile?.name,
+        bnkData,
+        sampleRate: EXPORT_SAMPLE_RATE,
+        stems,
+      };
+      const transfer: Transferable[] = [data.buffer];
+      if (bnkData) {
+        transfer.push(bnkData.buffer);
+      }
+      worker.postMessage(request, transfer);
+    });
+
+    return new Blob([wav], { type: "audio/wav" });
+  } finally {
+    worker.terminate();
+  }
+}
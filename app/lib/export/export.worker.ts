@@ -0,0 +1,252 @@
+/**
+ * export.worker.ts - 오프라인 렌더링 워커 (WAV 내보내기 / 배치 작업)
+ *
+ * 워커 안에서 별도의 WASM 모듈 인스턴스를 만들어 곡 전체를
+ * 실시간보다 빠르게 렌더링하고 WAV로 인코딩합니다.
+ * 재생 중인 메인 스레드 플레이어에는 영향을 주지 않습니다.
+ *
+ * 모듈 인스턴스는 워커마다 한 번만 로드되고 이후 작업에서 재사용되므로,
+ * batch-pool.ts가 같은 워커에 여러 작업(내보내기, 폴더 스캔, 라우드니스 분석,
+ * 탐색 막대 엔벨로프)을 연달아 보낼 수 있습니다.
+ */
+
+import { AdPlugPlayer } from "../adplug/adplug";
+import { LibOpenMPTPlayer } from "../libopenmpt/libopenmpt";
+import { getPlayerType } from "../format-detection";
+
+// 작업 종류 (kind를 생략하면 'export')
+export type BatchJobKind = 'export' | 'scan' | 'loudness' | 'overview';
+
+export interface ExportRequest {
+  id: number;
+  kind?: BatchJobKind;
+  filename: string;
+  data: Uint8Array;
+  bnkFilename?: string;
+  bnkData?: Uint8Array;
+  sampleRate: number;
+  stems?: boolean;   // 채널별 스템 (멀티채널 WAV)
+  buckets?: number;  // 라우드니스 분석 / 엔벨로프 구간 수
+}
+
+// 폴더 스캔 결과 (재생 없이 로드만 해서 얻는 정보)
+export interface ScanResult {
+  engine: 'adplug' | 'libopenmpt';
+  title: string;
+  author: string;
+  type: string;
+  durationMs: number;
+  subsongs: number;
+}
+
+/**
+ * 라우드니스 분석 결과
+ * 탐색 막대용 엔벨로프 렌더링을 그대로 사용하므로 곡 사이 상대 비교용 근사값입니다
+ * (AdPlug는 MAME OPL 코어 11025Hz 모노, libopenmpt는 8000Hz 모노)
+ */
+export interface LoudnessResult {
+  durationMs: number;
+  peak: number;      // 0.0 ~ 1.0
+  peakDb: number;    // dBFS
+  rmsDb: number;     // 곡 전체 RMS (dBFS)
+  min: Float32Array; // 구간별 엔벨로프
+  max: Float32Array;
+  rms: Float32Array;
+}
+
+/**
+ * 탐색 막대용 엔벨로프 (곡 전체 분석 패스라 메인 스레드에서 돌리면 재생이 끊김)
+ */
+export interface OverviewResult {
+  buckets: number;
+  durationMs: number;
+  min: Float32Array; // -1.0 ~ 0.0
+  max: Float32Array; // 0.0 ~ 1.0
+  rms: Float32Array; // 0.0 ~ 1.0
+}
+
+export type ExportResponse =
+  | { id: number; type: 'progress'; progress: number }
+  | { id: number; type: 'done'; wav: ArrayBuffer }
+  | { id: number; type: 'scan'; result: ScanResult }
+  | { id: number; type: 'loudness'; result: LoudnessResult }
+  | { id: number; type: 'overview'; result: OverviewResult }
+  | { id: number; type: 'error'; message: string };
+
+type JobResult =
+  | { type: 'done'; wav: ArrayBuffer }
+  | { type: 'scan'; result: ScanResult }
+  | { type: 'loudness'; result: LoudnessResult }
+  | { type: 'overview'; result: OverviewResult };
+
+// 무음 구간을 -Infinity 대신 표현할 하한
+const SILENCE_DB = -120;
+const DEFAULT_LOUDNESS_BUCKETS = 1024;
+
+// eslint-disable-next-line @typescript-eslint/no-explicit-any
+const workerScope = self as any;
+
+function toDb(value: number): number {
+  return value > 0 ? Math.max(SILENCE_DB, 20 * Math.log10(value)) : SILENCE_DB;
+}
+
+/**
+ * 엔벨로프에서 피크 / 전체 RMS 계산 (구간 길이가 같으므로 단순 평균)
+ */
+function summarizeLoudness(
+  min: Float32Array,
+  max: Float32Array,
+  rms: Float32Array,
+  durationMs: number
+): LoudnessResult {
+  let peak = 0;
+  let sumSquares = 0;
+  for (let i = 0; i < rms.length; i++) {
+    peak = Math.max(peak, max[i], -min[i]);
+    sumSquares += rms[i] * rms[i];
+  }
+  const total = rms.length > 0 ? Math.sqrt(sumSquares / rms.length) : 0;
+  return { durationMs, peak, peakDb: toDb(peak), rmsDb: toDb(total), min, max, rms };
+}
+
+async function runLibOpenMPT(request: ExportRequest, onProgress: (progress: number) => void): Promise<JobResult> {
+  const player = new LibOpenMPTPlayer();
+  await player.init(request.sampleRate);
+  try {
+    if (!player.load(request.filename, request.data)) {
+      throw new Error("Failed to load music file. Format may not be supported.");
+    }
+
+    if (request.kind === 'scan') {
+      const info = player.getTrackInfo();
+      return {
+        type: 'scan',
+        result: {
+          engine: 'libopenmpt',
+          title: info.title,
+          author: info.artist,
+          type: info.type,
+          durationMs: Math.round(player.getDurationSeconds() * 1000),
+          subsongs: 1,
+        },
+      };
+    }
+
+    if (request.kind === 'loudness' || request.kind === 'overview') {
+      const overview = player.renderOverview(request.buckets ?? DEFAULT_LOUDNESS_BUCKETS);
+      if (!overview) {
+        throw new Error("Analysis failed");
+      }
+      const durationMs = overview.durationSeconds * 1000;
+      if (request.kind === 'overview') {
+        const { buckets, min, max, rms } = overview;
+        return { type: 'overview', result: { buckets, durationMs, min, max, rms } };
+      }
+      return {
+        type: 'loudness',
+        result: summarizeLoudness(overview.min, overview.max, overview.rms, durationMs),
+      };
+    }
+
+    const wav = player.exportWav(onProgress, request.stems ?? false);
+    if (!wav) {
+      throw new Error("Export failed");
+    }
+    return { type: 'done', wav: wav.buffer as ArrayBuffer };
+  } finally {
+    player.destroy();
+  }
+}
+
+async function runAdPlug(request: ExportRequest, onProgress: (progress: number) => void): Promise<JobResult> {
+  const player = new AdPlugPlayer();
+  await player.init(request.sampleRate);
+  try {
+    if (request.bnkFilename && request.bnkData) {
+      player.addFile(request.bnkFilename, request.bnkData);
+    }
+    if (!player.load(request.filename, request.data)) {
+      throw new Error("Failed to load music file. Format may not be supported.");
+    }
+
+    if (request.kind === 'scan') {
+      const state = player.getState();
+      return {
+        type: 'scan',
+        result: {
+          engine: 'adplug',
+          title: state.trackInfo.title,
+          author: state.trackInfo.author,
+          type: state.trackInfo.type,
+          durationMs: state.maxPosition,
+          subsongs: state.subsongCount,
+        },
+      };
+    }
+
+    if (request.kind === 'loudness' || request.kind === 'overview') {
+      const overview = player.renderOverview(request.buckets ?? DEFAULT_LOUDNESS_BUCKETS);
+      if (!overview) {
+        throw new Error("Analysis failed");
+      }
+      if (request.kind === 'overview') {
+        return { type: 'overview', result: overview };
+      }
+      return {
+        type: 'loudness',
+        result: summarizeLoudness(overview.min, overview.max, overview.rms, overview.durationMs),
+      };
+    }
+
+    const wav = player.exportWav(onProgress, request.stems ?? false);
+    if (!wav) {
+      throw new Error("Export failed");
+    }
+    return { type: 'done', wav: wav.buffer as ArrayBuffer };
+  } finally {
+    player.destroy();
+  }
+}
+
+/**
+ * 파일 포맷에 맞는 엔진으로 작업 실행
+ */
+async function runJob(request: ExportRequest, onProgress: (progress: number) => void): Promise<JobResult> {
+  const playerType = getPlayerType(request.filename);
+
+  if (playerType === 'libopenmpt') {
+    return runLibOpenMPT(request, onProgress);
+  }
+  if (playerType === 'adplug') {
+    return runAdPlug(request, onProgress);
+  }
+
+  throw new Error(`Unsupported format: ${request.filename}`);
+}
+
+// 결과 버퍼는 복사 없이 메인 스레드로 넘김
+function transferList(result: JobResult): Transferable[] {
+  if (result.type === 'done') {
+    return [result.wav];
+  }
+  if (result.type === 'loudness' || result.type === 'overview') {
+    return [result.result.min.buffer, result.result.max.buffer, result.result.rms.buffer] as ArrayBuffer[];
+  }
+  return [];
+}
+
+workerScope.onmessage = async (event: MessageEvent<ExportRequest>) => {
+  const request = event.data;
+  const post = (response: ExportResponse, transfer: Transferable[] = []) => {
+    workerScope.postMessage(response, transfer);
+  };
+
+  try {
+    const result = await runJob(request, (progress) => {
+      post({ id: request.id, type: 'progress', progress });
+    });
+    post({ id: request.id, ...result } as ExportResponse, transferList(result));
+  } catch (err) {
+    post({ id: request.id, type: 'error', message: err instanceof Error ? err.message : "Unknown error" });
+  }
+};
@@ -40,6 +40,7 @@ interface UseAdPlugPlayerOptions {
   sharedAudioContextRef?: RefObject<AudioContext | null>;
   sharedStreamFactoryRef?: RefObject<StreamNodeFactory | null>;
   audioElementRef?: RefObject<HTMLAudioElement | null>;
+  adaptiveQuality?: boolean; // 렌더 비용에 따라 품질 자동 조절 (기본 꺼짐)
 }
 
 interface UseAdPlugPlayerReturn {
@@ -65,6 +66,7 @@ interface UseAdPlugPlayerReturn {
 
 const SAMPLE_RATE = 44100; // 표준 샘플레이트 (브라우저 호환성)
 const BUFFER_FRAME_COUNT = 131072; // 링 버퍼 크기 (~3초 at 44100Hz, 백그라운드 탭 throttle 대응)
+const LOOP_CACHE_BUDGET_BYTES = 32 * 1024 * 1024; // 한곡 반복용 PCM 캐시 (~3분 at 44100Hz 스테레오)
 
 /**
  * AdPlug 통합 플레이어 React 훅
@@ -78,6 +80,7 @@ export function useAdPlugPlayer({
   sharedAudioContextRef,
   sharedStreamFactoryRef,
   audioElementRef,
+  adaptiveQuality = false,
 }: UseAdPlugPlayerOptions): UseAdPlugPlayerReturn {
   const [state, setState] = useState<AdPlugPlaybackState | null>(null);
   const [isLoading, setIsLoading] = useState(false);
@@ -112,6 +115,9 @@ export function useAdPlugPlayer({
   // 루프 모드
   const loopEnabledRef = useRef<boolean>(false);
 
+  // 적응형 품질 (초기화 시점에 최신 값을 쓰기 위해 ref로 유지)
+  const adaptiveQualityRef = useRef<boolean>(adaptiveQuality);
+
   // 트랙 종료 콜백 중복 호출 방지
   const trackEndCallbackFiredRef = useRef<boolean>(false);
 
@@ -259,6 +265,14 @@ export function useAdPlugPlayer({
     }
   }, []);
 
+  /**
+   * 적응형 품질 설정 반영
+   */
+  useEffect(() => {
+    adaptiveQualityRef.current = adaptiveQuality;
+    playerRef.current?.setAdaptiveQuality(adaptiveQuality);
+  }, [adaptiveQuality]);
+
   /**
    * 파일 로드 및 플레이어 초기화
    */
@@ -358,6 +372,9 @@ export function useAdPlugPlayer({
           return;
         }
 
+        // 켜져 있으면 저사양 기기에서 끊김 대신 음질을 낮추도록 렌더 비용에 따라 품질 자동 조절
+        player.setAdaptiveQuality(adaptiveQualityRef.current);
+
         // BNK 파일 추가 (있는 경우)
         if (bnkFile) {
           const bnkBuffer = await bnkFile.arrayBuffer();
@@ -787,6 +804,8 @@ export function useAdPlugPlayer({
     loopEnabledRef.current = enabled;
     if (playerRef.current) {
       playerRef.current.setLoopEnabled(enabled);
+      // 한곡 반복 시 두 번째 루프부터 캐시에서 재생 (재합성 없이 배터리 절약)
+      playerRef.current.setLoopCacheBudget(enabled ? LOOP_CACHE_BUDGET_BYTES : 0);
     }
   }, []);
 
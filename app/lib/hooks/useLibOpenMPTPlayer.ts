@@ -39,6 +39,7 @@ interface UseLibOpenMPTPlayerOptions {
   sharedAudioContextRef?: RefObject<AudioContext | null>;
   sharedStreamFactoryRef?: RefObject<StreamNodeFactory | null>;
   audioElementRef?: RefObject<HTMLAudioElement | null>;
+  adaptiveQuality?: boolean; // 렌더 비용에 따라 품질 자동 조절 (기본 꺼짐)
 }
 
 interface UseLibOpenMPTPlayerReturn {
@@ -76,6 +77,7 @@ export function useLibOpenMPTPlayer({
   sharedAudioContextRef,
   sharedStreamFactoryRef,
   audioElementRef,
+  adaptiveQuality = false,
 }: UseLibOpenMPTPlayerOptions): UseLibOpenMPTPlayerReturn {
   const [state, setState] = useState<LibOpenMPTPlaybackState | null>(null);
   const [isLoading, setIsLoading] = useState(false);
@@ -110,6 +112,9 @@ export function useLibOpenMPTPlayer({
   // 루프 모드
   const loopEnabledRef = useRef<boolean>(false);
 
+  // 적응형 품질 (초기화 시점에 최신 값을 쓰기 위해 ref로 유지)
+  const adaptiveQualityRef = useRef<boolean>(adaptiveQuality);
+
   // 트랙 종료 콜백 중복 호출 방지
   const trackEndCallbackFiredRef = useRef<boolean>(false);
 
@@ -258,6 +263,14 @@ export function useLibOpenMPTPlayer({
     }
   }, []);
 
+  /**
+   * 적응형 품질 설정 반영
+   */
+  useEffect(() => {
+    adaptiveQualityRef.current = adaptiveQuality;
+    playerRef.current?.setAdaptiveQuality(adaptiveQuality);
+  }, [adaptiveQuality]);
+
   /**
    * 파일 로드 및 플레이어 초기화
    */
@@ -357,6 +370,9 @@ export function useLibOpenMPTPlayer({
           return;
         }
 
+        // 켜져 있으면 저사양 기기에서 끊김 대신 음질을 낮추도록 렌더 비용에 따라 품질 자동 조절
+        player.setAdaptiveQuality(adaptiveQualityRef.current);
+
         // 음악 파일 로드
         const loaded = player.load(musicFile.name, musicData);
         if (!loaded) {
@@ -5,6 +5,11 @@
  * using the official libopenmpt library compiled to WebAssembly.
  */
 
+import { loadEmscriptenFactory } from "../emscripten-loader";
+import { readRenderStats, type RenderStats } from "../render-stats";
+import { readPlaybackSnapshot, type PlaybackSnapshot } from "../playback-state";
+import { readPatternChanges, type PatternChange } from "../pattern-state";
+
 // Types for Emscripten module with libopenmpt C API
 interface LibOpenMPTEmscriptenModule {
   _malloc(size: number): number;
@@ -37,6 +42,35 @@ interface LibOpenMPTEmscriptenModule {
   _openmpt_module_set_render_param(mod: number, param: number, value: number): number;
   _openmpt_free_string(str: number): void;
 
+  // Adapter functions (wasm/libopenmpt/adapter.cpp)
+  // Optional: missing from builds that only link the C API (older public/libopenmpt.wasm)
+  _mpt_init?(sampleRate: number): number;
+  _mpt_load_file?(filenamePtr: number, dataPtr: number, size: number): number;
+  _mpt_render_overview?(buckets: number): number;
+  _mpt_get_overview_buffer?(): number;
+  _mpt_get_overview_buckets?(): number;
+  _mpt_export_begin?(stems: number): number;
+  _mpt_export_render?(maxFrames: number): number;
+  _mpt_export_get_buffer?(): number;
+  _mpt_export_get_length?(): number;
+  _mpt_export_end?(): void;
+  _mpt_trace_enable?(capacity: number): void;
+  _mpt_trace_clear?(): void;
+  _mpt_trace_export?(): number;
+  _mpt_stats_get?(): number;
+  _mpt_stats_reset?(): void;
+  // Optional: missing from builds that predate render statistics
+  _mpt_stats_record?(renderMs: number, frames: number, sampleRate: number): void;
+  _mpt_get_state_block?(): number;
+  _mpt_publish_state?(modulePtr: number, seeked: number): void;
+  _mpt_set_adaptive_quality?(enabled: number): void;
+  _mpt_get_quality_level?(): number;
+  _mpt_apply_quality?(modulePtr: number): number;
+  _mpt_read_block?(modulePtr: number, sampleRate: number, frames: number, out: number): number;
+  _mpt_seek?(modulePtr: number, seconds: number): number;
+  _mpt_get_pattern_state?(): number;
+  _mpt_set_pattern_tracking?(enabled: number): void;
+
   HEAP8: Int8Array;
   HEAP16: Int16Array;
   HEAP32: Int32Array;
@@ -64,62 +98,89 @@ export interface PlaybackState {
   trackInfo: TrackInfo;
 }
 
+/**
+ * Seek-bar waveform envelope for the whole song
+ * Cache it together with durationSeconds - both depend only on the file
+ */
+export interface WaveformOverview {
+  buckets: number;
+  min: Float32Array;  // -1.0 ~ 0.0
+  max: Float32Array;  // 0.0 ~ 1.0
+  rms: Float32Array;  // 0.0 ~ 1.0
+  durationSeconds: number;
+}
+
 // Audio buffer size (frames per call)
 const AUDIO_BUFFER_FRAMES = 1024;
 
+// Frames rendered per export call (large calls keep per-call overhead negligible)
+const EXPORT_CHUNK_FRAMES = 65536;
+
 // Render param indices (from libopenmpt)
 const OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL = 1;
 
 // Default master gain boost in millibels (100 mB = +1 dB)
 const DEFAULT_MASTER_GAIN_MILLIBEL = 100;
 
+// Smallest module using a SIMD instruction (i8x16.splat + i8x16.popcnt)
+const WASM_SIMD_PROBE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
 // Module loader cache
 let modulePromise: Promise<LibOpenMPTEmscriptenModule> | null = null;
 
+/**
+ * Check whether the browser runs WASM SIMD (libopenmpt-simd build)
+ */
+function supportsWasmSimd(): boolean {
+  try {
+    return typeof WebAssembly !== 'undefined' && WebAssembly.validate(WASM_SIMD_PROBE);
+  } catch {
+    return false;
+  }
+}
+
+/**
+ * Load and instantiate one build of the module
+ * @param name Base name of the .js / .wasm pair (both builds export 'libopenmpt')
+ */
+async function instantiate(name: string): Promise<LibOpenMPTEmscriptenModule> {
+  // Load the Emscripten JS file (script tag on main thread, eval in workers)
+  const factory = await loadEmscriptenFactory(`/${name}.js`, 'libopenmpt');
+
+  // Initialize the module
+  return factory({
+    locateFile: (path: string) => {
+      if (path.endsWith('.wasm')) {
+        return `/${name}.wasm`;
+      }
+      return path;
+    }
+  }) as Promise<LibOpenMPTEmscriptenModule>;
+}
+
 /**
  * Load the libopenmpt WASM module
+ * Prefers the SIMD build (wasm/libopenmpt/build.sh simd) and falls back to
+ * the scalar one when SIMD is unsupported or the SIMD build is not deployed
  */
 async function loadModule(): Promise<LibOpenMPTEmscriptenModule> {
   if (modulePromise) {
     return modulePromise;
   }
 
-  modulePromise = new Promise(async (resolve, reject) => {
-    try {
-      // Load the Emscripten JS file dynamically
-      const script = document.createElement('script');
-      script.src = '/libopenmpt.js';
-
-      script.onload = async () => {
-        // libopenmpt should be available globally after script loads
-        const libopenmpt = (window as any).libopenmpt;
-        if (!libopenmpt) {
-          reject(new Error('libopenmpt not found after script load'));
-          return;
-        }
-
-        // Initialize the module
-        const module = await libopenmpt({
-          locateFile: (path: string) => {
-            if (path.endsWith('.wasm')) {
-              return '/libopenmpt.wasm';
-            }
-            return path;
-          }
-        });
-
-        resolve(module);
-      };
-
-      script.onerror = () => {
-        reject(new Error('Failed to load libopenmpt.js'));
-      };
-
-      document.head.appendChild(script);
-    } catch (err) {
-      reject(err);
+  modulePromise = (async () => {
+    if (supportsWasmSimd()) {
+      try {
+        return await instantiate('libopenmpt-simd');
+      } catch {
+        // Not deployed or failed to start: drop its factory so the scalar script defines its own
+        delete (globalThis as Record<string, unknown>).libopenmpt;
+      }
     }
-  });
+    return instantiate('libopenmpt');
+  })();
 
   return modulePromise;
 }
@@ -135,6 +196,12 @@ export class LibOpenMPTPlayer {
   private isPlaying = false;
   private sampleRate = 48000;
   private fileLoaded = false;
+  private seekedSincePublish = false; // 게시된 상태의 루프 카운트가 탐색을 루프로 세지 않도록
+  private appliedQualityLevel = 0; // modulePtr에 적용된 품질 단계 (새 모듈은 기본값 = 0단계)
+
+  // Loaded file kept for adapter-side analysis (overview etc.)
+  private fileData: Uint8Array | null = null;
+  private adapterFileLoaded = false;
 
   // Audio buffer allocated in WASM heap
   private audioBufferPtr: number = 0;
@@ -187,6 +254,7 @@ export class LibOpenMPTPlayer {
     this.module.HEAPU8.set(data, dataPtr);
 
     // Create module from memory
+    this.appliedQualityLevel = 0;
     this.modulePtr = this.module._openmpt_module_create_from_memory2(
       dataPtr,
       data.length,
@@ -217,11 +285,114 @@ export class LibOpenMPTPlayer {
       DEFAULT_MASTER_GAIN_MILLIBEL
     );
 
+    this.fileData = data;
+    this.adapterFileLoaded = false;
     this.fileLoaded = true;
     this.isPlaying = true;
     return true;
   }
 
+  /**
+   * Make sure the adapter has its own copy of the loaded file
+   * Playback uses the libopenmpt C API directly; analysis goes through adapter.cpp
+   */
+  private ensureAdapterFile(): boolean {
+    if (!this.module?._mpt_init || !this.module._mpt_load_file || !this.fileData) {
+      return false;
+    }
+    if (this.adapterFileLoaded) {
+      return true;
+    }
+
+    if (this.module._mpt_init(this.sampleRate) !== 0) {
+      return false;
+    }
+
+    const dataPtr = this.module._malloc(this.fileData.length);
+    this.module.HEAPU8.set(this.fileData, dataPtr);
+    const result = this.module._mpt_load_file(0, dataPtr, this.fileData.length);
+    this.module._free(dataPtr);
+
+    this.adapterFileLoaded = result === 0;
+    return this.adapterFileLoaded;
+  }
+
+  /**
+   * Render the whole module to a 16-bit stereo WAV file as fast as possible
+   * Blocks until done - call it from a Web Worker with its own module instance
+   * @param onProgress Called with progress 0.0 ~ 1.0 after each render chunk
+   * @param stems Write one WAV channel per tracker channel instead of the stereo mix
+   *              Each channel that plays a note is a full render of its own, so this
+   *              takes about as many times longer as there are such channels
+   */
+  exportWav(onProgress?: (progress: number) => void, stems = false): Uint8Array | null {
+    const module = this.module;
+    if (!module || !this.fileLoaded || !module._mpt_export_begin || !module._mpt_export_render ||
+        !module._mpt_export_get_buffer || !module._mpt_export_get_length || !module._mpt_export_end ||
+        !this.ensureAdapterFile()) {
+      return null;
+    }
+
+    if (module._mpt_export_begin(stems ? 1 : 0) !== 0) {
+      return null;
+    }
+
+    let result = 0;
+    while (result >= 0 && result < 1000) {
+      result = module._mpt_export_render(EXPORT_CHUNK_FRAMES);
+      if (onProgress && result >= 0) {
+        onProgress(result / 1000);
+      }
+    }
+
+    let wav: Uint8Array | null = null;
+    if (result === 1000) {
+      const ptr = module._mpt_export_get_buffer();
+      const length = module._mpt_export_get_length();
+      wav = module.HEAPU8.slice(ptr, ptr + length);
+    }
+
+    module._mpt_export_end();
+    return wav;
+  }
+
+  /**
+   * Render a min/max/RMS envelope of the whole song for the seek bar
+   * Uses a separate low-rate analysis pass, so playback state is not affected
+   * Blocks for the whole pass - call it from a Web Worker with its own module
+   * instance (BatchPool.renderOverview), not on the playback thread
+   */
+  renderOverview(buckets: number): WaveformOverview | null {
+    const module = this.module;
+    if (!module || !this.fileLoaded || !module._mpt_render_overview ||
+        !module._mpt_get_overview_buckets || !module._mpt_get_overview_buffer ||
+        !this.ensureAdapterFile()) {
+      return null;
+    }
+
+    if (module._mpt_render_overview(buckets) !== 0) {
+      return null;
+    }
+
+    const count = module._mpt_get_overview_buckets();
+    const start = module._mpt_get_overview_buffer() / 4; // byte offset to float32 offset
+    const data = module.HEAPF32.subarray(start, start + count * 3);
+
+    const overview: WaveformOverview = {
+      buckets: count,
+      min: new Float32Array(count),
+      max: new Float32Array(count),
+      rms: new Float32Array(count),
+      durationSeconds: this.getDurationSeconds(),
+    };
+    for (let i = 0; i < count; i++) {
+      overview.min[i] = data[i * 3];
+      overview.max[i] = data[i * 3 + 1];
+      overview.rms[i] = data[i * 3 + 2];
+    }
+    return overview;
+  }
+
   /**
    * Generate audio samples
    * Returns Float32Array of stereo samples (interleaved L/R)
@@ -231,13 +402,23 @@ export class LibOpenMPTPlayer {
       return { samples: new Float32Array(0), finished: true };
     }
 
-    // Read interleaved stereo float samples
-    const framesRead = this.module._openmpt_module_read_interleaved_float_stereo(
+    // Read interleaved stereo float samples (in steps that record pattern changes when available)
+    const renderStart = performance.now();
+    const read = this.module._mpt_read_block ?? this.module._openmpt_module_read_interleaved_float_stereo;
+    const framesRead = read(
       this.modulePtr,
       this.sampleRate,
       AUDIO_BUFFER_FRAMES,
       this.audioBufferPtr
     );
+    this.module._mpt_stats_record?.(performance.now() - renderStart, framesRead, this.sampleRate);
+    const qualityLevel = this.module._mpt_get_quality_level?.() ?? 0;
+    if (qualityLevel !== this.appliedQualityLevel) {
+      this.module._mpt_apply_quality?.(this.modulePtr);
+      this.appliedQualityLevel = qualityLevel;
+    }
+    this.module._mpt_publish_state?.(this.modulePtr, this.seekedSincePublish ? 1 : 0);
+    this.seekedSincePublish = false;
 
     // Calculate number of float samples
     const numSamples = framesRead * 2; // stereo
@@ -293,7 +474,10 @@ export class LibOpenMPTPlayer {
    */
   seek(seconds: number): void {
     if (this.module && this.modulePtr !== 0) {
-      this.module._openmpt_module_set_position_seconds(this.modulePtr, seconds);
+      // Traced through the adapter when available
+      const setPosition = this.module._mpt_seek ?? this.module._openmpt_module_set_position_seconds;
+      setPosition(this.modulePtr, seconds);
+      this.seekedSincePublish = true;
     }
   }
 
@@ -389,6 +573,104 @@ export class LibOpenMPTPlayer {
     this.isPlaying = playing;
   }
 
+  /**
+   * Read the state block published by the last render call
+   * (position, row, channel VU, loop count) without calling into the engine
+   */
+  getPlaybackSnapshot(): PlaybackSnapshot | null {
+    if (!this.module?._mpt_get_state_block) {
+      return null;
+    }
+    return readPlaybackSnapshot(this.module.HEAPU8.buffer, this.module._mpt_get_state_block());
+  }
+
+  /**
+   * Record pattern changes within each block, not only at its start
+   * Costs extra libopenmpt read calls; enable while a pattern view is open
+   */
+  setPatternTracking(enabled: boolean): void {
+    this.module?._mpt_set_pattern_tracking?.(enabled ? 1 : 0);
+  }
+
+  /**
+   * Pattern position changes during the last generateSamples() call,
+   * with frame offsets into the block
+   * Without setPatternTracking(true) only the position at the block start
+   */
+  getPatternChanges(): PatternChange[] {
+    if (!this.module?._mpt_get_pattern_state) {
+      return [];
+    }
+    return readPatternChanges(this.module.HEAP32, this.module._mpt_get_pattern_state());
+  }
+
+  /**
+   * Location of the state block, for readers on other threads
+   * Only useful across threads when the module memory is a SharedArrayBuffer
+   */
+  getStateBlock(): { buffer: ArrayBufferLike; ptr: number } | null {
+    if (!this.module?._mpt_get_state_block) {
+      return null;
+    }
+    return { buffer: this.module.HEAPU8.buffer, ptr: this.module._mpt_get_state_block() };
+  }
+
+  /**
+   * Get render deadline statistics (render time vs. duration of the audio produced)
+   */
+  getRenderStats(): RenderStats | null {
+    // _mpt_stats_record가 없으면 통계를 지원하지 않는 빌드
+    if (!this.module?._mpt_stats_record || !this.module._mpt_stats_get) {
+      return null;
+    }
+    return readRenderStats(this.module.HEAPU32, this.module._mpt_stats_get());
+  }
+
+  /**
+   * Reset render deadline statistics (e.g. per reporting interval)
+   */
+  resetRenderStats(): void {
+    if (this.module?._mpt_stats_record) {
+      this.module._mpt_stats_reset?.();
+    }
+  }
+
+  /**
+   * Let render cost drive interpolation quality
+   * Under sustained load the sinc filter drops to linear interpolation;
+   * quality returns after a few seconds of headroom
+   */
+  setAdaptiveQuality(enabled: boolean): void {
+    this.module?._mpt_set_adaptive_quality?.(enabled ? 1 : 0);
+  }
+
+  /**
+   * Get the current quality level (0 = full quality, 1 = linear interpolation)
+   */
+  getQualityLevel(): number {
+    return this.module?._mpt_get_quality_level?.() ?? 0;
+  }
+
+  /**
+   * Record the adapter timeline (render blocks, loads, seeks, export, overview)
+   * Playback is traced through _mpt_read_block / _mpt_seek; builds without
+   * them record only loads, export and overview
+   * @param capacity Number of spans kept, oldest dropped first; 0 stops and frees the ring
+   */
+  setTraceCapacity(capacity: number): void {
+    this.module?._mpt_trace_enable?.(Math.max(0, Math.floor(capacity)));
+  }
+
+  /**
+   * Export recorded spans as Chrome trace-event JSON (open in Perfetto)
+   */
+  exportTrace(): string | null {
+    if (!this.module?._mpt_trace_export) {
+      return null;
+    }
+    return this.module.UTF8ToString(this.module._mpt_trace_export());
+  }
+
   /**
    * Check if file is loaded
    */
@@ -410,6 +692,8 @@ export class LibOpenMPTPlayer {
         this.audioBufferPtr = 0;
       }
     }
+    this.fileData = null;
+    this.adapterFileLoaded = false;
     this.isInitialized = false;
     this.fileLoaded = false;
     this.isPlaying = false;
@@ -0,0 +1,50 @@
+/**
+ * pattern-state.ts - 렌더 블록 안의 패턴 위치 변화 읽기 (어댑터 공용)
+ *
+ * 엔진은 렌더 호출이 끝난 시점의 위치만 알려주므로, 그 값을 폴링하는
+ * 패턴 뷰는 늦거나 행을 건너뜁니다. 어댑터는 렌더링 중 (오더, 패턴, 행,
+ * 속도)가 바뀔 때마다 블록 안의 프레임 오프셋과 함께 기록하고, UI는 렌더
+ * 호출 뒤에 그 목록을 읽어 오디오 출력 시각에 맞춰 행을 표시합니다.
+ * 레이아웃은 wasm/common/pattern_state.h의 PatternState 구조체와 같아야 합니다.
+ */
+
+export const PATTERN_STATE_MAX_CHANGES = 64;
+
+/** changes 앞의 32비트 필드 수 (count, dropped) */
+const PATTERN_STATE_HEADER_FIELDS = 2;
+
+/** 변화 하나의 32비트 필드 수 */
+const PATTERN_CHANGE_FIELDS = 5;
+
+export interface PatternChange {
+  /** 블록 시작부터의 프레임 오프셋 (이 프레임부터 이 위치) */
+  frame: number;
+  order: number;
+  pattern: number;
+  row: number;
+  /** 행당 틱 수 */
+  speed: number;
+}
+
+/**
+ * WASM 메모리의 PatternState 구조체에서 마지막 렌더 호출의 변화 목록 복사
+ * 용량을 넘긴 변화는 버려지고 마지막 항목이 가장 최근 위치를 가집니다
+ * @param heap 모듈의 HEAP32
+ * @param ptr 구조체 주소 (바이트 오프셋)
+ */
+export function readPatternChanges(heap: Int32Array, ptr: number): PatternChange[] {
+  const base = ptr >>> 2;
+  const count = Math.min(heap[base] >>> 0, PATTERN_STATE_MAX_CHANGES);
+  const changes: PatternChange[] = [];
+  for (let i = 0; i < count; i++) {
+    const at = base + PATTERN_STATE_HEADER_FIELDS + i * PATTERN_CHANGE_FIELDS;
+    changes.push({
+      frame: heap[at] >>> 0,
+      order: heap[at + 1],
+      pattern: heap[at + 2],
+      row: heap[at + 3],
+      speed: heap[at + 4],
+    });
+  }
+  return changes;
+}
@@ -0,0 +1,52 @@
+/**
+ * playback-state.ts - 어댑터가 게시하는 재생 상태 블록 읽기
+ *
+ * 어댑터는 렌더 호출마다 WASM 메모리의 PublishedState 블록을 통째로
+ * 갱신합니다. WASM 빌드는 단일 스레드(-pthread 없음)라 힙이 일반
+ * ArrayBuffer이고, 모듈을 가진 스레드에서 렌더 호출 사이에만 읽으므로
+ * 쓰는 도중인 블록을 볼 일이 없어 그대로 복사하면 됩니다.
+ * 레이아웃은 wasm/common/state_block.h와 같아야 합니다.
+ */
+
+export const STATE_MAX_CHANNELS = 64;
+
+/** levels 앞의 32비트 필드 수 */
+const STATE_HEADER_FIELDS = 8;
+
+export interface PlaybackSnapshot {
+  /** 스냅샷 버전 (게시할 때마다 1씩 증가) */
+  version: number;
+  positionMs: number;
+  /** 플레이어 틱 (libopenmpt는 항상 0) */
+  tick: number;
+  /** 오더/패턴/행 (포맷에 없으면 -1 또는 0) */
+  order: number;
+  pattern: number;
+  row: number;
+  /** 처음으로 되돌아간 횟수 */
+  loopCount: number;
+  /** 채널별 레벨 0.0 ~ 1.0 */
+  levels: Float32Array;
+}
+
+/**
+ * 상태 블록 읽기
+ * @param buffer WASM 메모리 버퍼 (메모리 증가 후에는 새 버퍼를 넘겨야 함)
+ * @param ptr 상태 블록 주소 (바이트 오프셋)
+ * @returns 스냅샷
+ */
+export function readPlaybackSnapshot(buffer: ArrayBufferLike, ptr: number): PlaybackSnapshot {
+  const header = new Int32Array(buffer, ptr, STATE_HEADER_FIELDS);
+  const levels = new Float32Array(buffer, ptr + STATE_HEADER_FIELDS * 4, STATE_MAX_CHANNELS);
+  const channelCount = Math.min(header[7] >>> 0, STATE_MAX_CHANNELS);
+  return {
+    version: header[0] >>> 0,
+    positionMs: header[1] >>> 0,
+    tick: header[2] >>> 0,
+    order: header[3],
+    pattern: header[4],
+    row: header[5],
+    loopCount: header[6] >>> 0,
+    levels: levels.slice(0, channelCount),
+  };
+}
@@ -0,0 +1,70 @@
+/**
+ * render-stats.ts - 렌더 데드라인 통계 (어댑터 공용)
+ *
+ * 어댑터는 렌더 호출마다 "렌더 시간 / 생성된 오디오 길이" 비율을 로그 버킷
+ * 히스토그램에 누적합니다. AdPlug는 OPL 레지스터 쓰기 중 값이 바뀌지 않아
+ * 버린 쓰기 수도 함께 보고합니다. 레이아웃은 wasm/common/render_stats.h의
+ * RenderStats 구조체와 같아야 합니다.
+ */
+
+/** 히스토그램 범위: 2^-10 ~ 2^6, 옥타브당 4개 버킷 */
+export const RENDER_STATS_BUCKETS_PER_OCTAVE = 4;
+export const RENDER_STATS_MIN_LOG2 = -10;
+export const RENDER_STATS_BUCKETS = 16 * RENDER_STATS_BUCKETS_PER_OCTAVE;
+
+/** 버킷 앞의 uint32 필드 수 (calls, over50, over80, over100, worstPermille) */
+const RENDER_STATS_HEADER_FIELDS = 5;
+
+export interface RenderStats {
+  /** 측정된 렌더 호출 수 */
+  calls: number;
+  /** 오디오 길이의 50% / 80% / 100%를 넘긴 호출 수 */
+  over50: number;
+  over80: number;
+  over100: number;
+  /** 가장 나빴던 비율 (1.0 = 실시간과 같음) */
+  worstRatio: number;
+  /** 버킷 i의 하한 비율은 renderStatsBucketLowerBound(i) */
+  histogram: Uint32Array;
+  /** 에뮬레이터에 전달된 / 중복이라 버린 레지스터 쓰기 수 (libopenmpt는 0) */
+  regWrites: number;
+  regWritesDropped: number;
+}
+
+/**
+ * 버린 레지스터 쓰기 비율 (0.0 ~ 1.0)
+ */
+export function droppedWriteRate(stats: RenderStats): number {
+  const total = stats.regWrites + stats.regWritesDropped;
+  return total > 0 ? stats.regWritesDropped / total : 0;
+}
+
+/**
+ * 버킷의 하한 비율 (렌더 시간 / 오디오 길이)
+ */
+export function renderStatsBucketLowerBound(bucket: number): number {
+  return Math.pow(2, RENDER_STATS_MIN_LOG2 + bucket / RENDER_STATS_BUCKETS_PER_OCTAVE);
+}
+
+/**
+ * WASM 메모리의 RenderStats 구조체를 복사해 읽기
+ * @param heap 모듈의 HEAPU32
+ * @param ptr 구조체 주소 (바이트 오프셋)
+ */
+export function readRenderStats(heap: Uint32Array, ptr: number): RenderStats {
+  const base = ptr >>> 2;
+  const writes = base + RENDER_STATS_HEADER_FIELDS + RENDER_STATS_BUCKETS;
+  return {
+    calls: heap[base],
+    over50: heap[base + 1],
+    over80: heap[base + 2],
+    over100: heap[base + 3],
+    worstRatio: heap[base + 4] / 1000,
+    histogram: heap.slice(
+      base + RENDER_STATS_HEADER_FIELDS,
+      base + RENDER_STATS_HEADER_FIELDS + RENDER_STATS_BUCKETS
+    ),
+    regWrites: heap[writes],
+    regWritesDropped: heap[writes + 1],
+  };
+}
@@ -7,13 +7,27 @@
 
 #include <cstdint>
 #include <cstring>
+#include <cmath>
 #include <string>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "adplug.h"
-#include "nemuopl.h"
+#include "emuopl.h"
 #include "binstr.h"
 
+#include "chanopl.h"
+#include "qualityopl.h"
+#include "reglog.h"
+
+#include "wav.h"
+#include "trace.h"
+#include "render_stats.h"
+#include "state_block.h"
+#include "pattern_state.h"
+#include "quality.h"
+
 // Audio buffer size (samples per channel)
 static const int AUDIO_BUFFER_SIZE = 512;
 
@@ -21,9 +35,29 @@ static const int AUDIO_BUFFER_SIZE = 512;
 static const int FIXED_POINT_SHIFT = 16;
 static const uint64_t FIXED_POINT_ONE = 1ULL << FIXED_POINT_SHIFT;
 
+// Overview (seek-bar waveform) analysis settings
+// Rendered mono at a low rate through the cheaper MAME OPL core
+static const int OVERVIEW_SAMPLE_RATE = 11025;
+static const unsigned long OVERVIEW_MAX_LENGTH_MS = 30UL * 60UL * 1000UL;
+static const int OVERVIEW_MAX_BUCKETS = 65536;
+
+// Fast-forward cue playback: each audible window is followed by
+// (rate - 1) windows of content whose ticks run without OPL synthesis
+static const int CUE_WINDOW_SAMPLES = 2048;
+static const int CUE_MAX_RATE = 16;
+
+// Oscilloscope capture limits (per-channel ring of decimated frames)
+static const int SCOPE_MAX_DECIMATION = 64;
+static const int SCOPE_MAX_FRAMES = 1 << 16;
+
+// Offline export: songs that never end are cut after this length
+static const unsigned long EXPORT_MAX_LENGTH_MS = 30UL * 60UL * 1000UL;
+
 // Global state
-static CNemuopl* g_opl = nullptr;
+static CChanopl* g_opl = nullptr;
+static CQualityopl* g_qualityOpl = nullptr; // What players write to: g_opl or a cheaper core
 static CPlayer* g_player = nullptr;
+static CRegLog g_regLog;                    // Register dumps play from here instead of g_player
 static int g_sampleRate = 49716;
 static int16_t* g_audioBuffer = nullptr;
 static int g_audioBufferLength = 0;
@@ -32,6 +66,54 @@ static unsigned long g_maxPosition = 0;
 static uint64_t g_sampleAccumulatorFixed = 0;  // Fixed-point accumulator
 static unsigned long g_totalSamplesGenerated = 0;
 static unsigned long g_currentTick = 0; // ISS 가사 동기화용 틱 카운터
+static int g_currentSubsong = 0;
+static std::string g_mainFilename;       // Main music file (for re-opening in analysis)
+static float* g_overviewBuffer = nullptr; // min/max/rms triplets per bucket
+static int g_overviewBuckets = 0;
+static int g_cueRate = 1;                 // 1 = normal playback
+static int g_cueWindowRemaining = 0;      // Audible samples left before the next skip
+static uint32_t g_loopCount = 0;          // Rewinds since load (published to readers)
+
+// Loop cache: the first full pass from the start of the song is recorded as
+// 16-bit PCM (within a memory budget); later rewinds and loops stream from it
+static size_t g_loopCacheBudget = 0;             // Bytes, 0 = disabled
+static std::vector<int16_t> g_loopCache;         // Interleaved stereo samples
+static std::vector<unsigned long> g_loopCacheTicks; // Tick count after each recorded block
+static bool g_loopCacheRecording = false;
+static bool g_loopCacheComplete = false;
+static bool g_loopCachePlaying = false;
+static size_t g_loopCacheReadPos = 0;            // Frames
+static int g_loopCacheLevel = 0;                 // Quality level the cache was recorded at
+
+// Offline export (WAV header + interleaved 16-bit stereo PCM)
+static std::vector<uint8_t> g_exportBuffer;
+static uint64_t g_exportFrames = 0;
+static uint64_t g_exportExpectedFrames = 0;
+static uint64_t g_exportMaxFrames = 0;
+static bool g_exportActive = false;
+static bool g_exportSavedLoopEnabled = false;
+static bool g_exportSavedAdaptive = false;       // Quality settings restored after the export
+static int g_exportSavedQualityLevel = 0;
+static int g_exportChannels = 2;                 // 2 = stereo mix, CChanopl::CHANNELS = stems
+
+// Oscilloscope ring: CChanopl::CHANNELS int16 values per captured frame
+static std::vector<int16_t> g_scopeRing;
+static int g_scopeFrames = 0;
+static int g_scopeDecimation = 1;
+
+// Pseudo-stereo width for OPL2-mode songs (0-100, 0 = chip mix)
+static int g_stereoWidth = 0;
+
+// State behind the helpers in ../common (each adapter has its own)
+static TraceRing g_trace;
+static RenderStats g_renderStats;
+static PublishedState g_publishedState;
+static PatternRecorder g_pattern;
+static QualityController g_quality = { false, 0, 0, 0.0, 0, 0 };
+
+// Last trace export (kept alive for the caller to read)
+static std::string g_traceJson;
+static std::vector<int16_t> g_exportMixScratch;  // Discarded stereo mix while writing stems
 
 // Track info strings
 static char g_title[256] = {0};
@@ -142,18 +224,607 @@ static CProvider_Memory g_memProvider;
 
 // Helper to calculate samples per tick in fixed-point format
 // Returns (sampleRate / refreshRate) * FIXED_POINT_ONE
-static uint64_t getSamplesPerTickFixed()
+static uint64_t samplesPerTickFixed(CPlayer* player, int sampleRate)
 {
-    if (!g_player) return 0;
-    double refreshRate = g_player->getrefresh();
-    if (refreshRate <= 0) refreshRate = 70.0; // Default
+    double refreshRate = player->getrefresh();
+    if (!(refreshRate > 0)) refreshRate = 70.0; // Default (also catches NaN)
+
+    // A tick is never shorter than one output sample; a bogus refresh rate
+    // from a damaged file would otherwise run millions of ticks per block
+    if (refreshRate > sampleRate) refreshRate = sampleRate;
 
     // Calculate in double, then convert to fixed-point once
     // This single conversion is precise; the accumulation uses integer math
-    double samplesPerTick = static_cast<double>(g_sampleRate) / refreshRate;
+    double samplesPerTick = static_cast<double>(sampleRate) / refreshRate;
     return static_cast<uint64_t>(samplesPerTick * FIXED_POINT_ONE);
 }
 
+// Samples per tick of the playback player at the output rate
+static uint64_t getSamplesPerTickFixed()
+{
+    if (!g_player) return 0;
+    return samplesPerTickFixed(g_player, g_sampleRate);
+}
+
+// Run one player tick (traced); the tick counter advances even at song end
+static bool tickPlayer()
+{
+    TraceSpan span(g_trace, "update", static_cast<int32_t>(g_currentTick));
+    bool stillPlaying = g_player->update();
+    g_currentTick++;
+    return stillPlaying;
+}
+
+// Record the player's pattern position at a frame of the block being rendered
+static void recordPatternState(int frame)
+{
+    patternStateRecord(g_pattern, static_cast<uint32_t>(frame),
+                       static_cast<int32_t>(g_player->getorder()),
+                       static_cast<int32_t>(g_player->getpattern()),
+                       static_cast<int32_t>(g_player->getrow()),
+                       static_cast<int32_t>(g_player->getspeed()));
+}
+
+// Advance the player over one cue skip without synthesizing audio
+// Register writes still reach the OPL (all at the current queue offset),
+// so chip state stays consistent
+// Returns false if the song ended during the skip
+static bool skipCueTicks(unsigned long* skippedSamples)
+{
+    uint64_t skipFixed = static_cast<uint64_t>(CUE_WINDOW_SAMPLES) * (g_cueRate - 1)
+                         << FIXED_POINT_SHIFT;
+    *skippedSamples = 0;
+
+    while (skipFixed > 0) {
+        if (g_sampleAccumulatorFixed >= FIXED_POINT_ONE) {
+            // Drop whole samples of the current tick
+            uint64_t available = g_sampleAccumulatorFixed & ~(FIXED_POINT_ONE - 1);
+            uint64_t take = available < skipFixed ? available : skipFixed;
+            g_sampleAccumulatorFixed -= take;
+            skipFixed -= take;
+            *skippedSamples += static_cast<unsigned long>(take >> FIXED_POINT_SHIFT);
+            continue;
+        }
+
+        if (!tickPlayer()) {
+            return false;
+        }
+        g_sampleAccumulatorFixed += getSamplesPerTickFixed();
+    }
+    return true;
+}
+
+// renderSamples() for songs decoded into the register log
+static int renderRegLog(int16_t* out, int maxSamples, int* samplesOut)
+{
+    int samplesGenerated = 0;
+    bool ended = false;
+
+    g_qualityOpl->beginQueue();
+
+    while (samplesGenerated < maxSamples) {
+        if (g_cueRate > 1 && g_cueWindowRemaining <= 0) {
+            g_regLog.skip(g_qualityOpl, static_cast<uint64_t>(CUE_WINDOW_SAMPLES) * (g_cueRate - 1));
+            g_cueWindowRemaining = CUE_WINDOW_SAMPLES;
+        }
+
+        int toGenerate = maxSamples - samplesGenerated;
+        if (g_cueRate > 1 && toGenerate > g_cueWindowRemaining) {
+            toGenerate = g_cueWindowRemaining;
+        }
+        int covered = g_regLog.queue(g_qualityOpl, toGenerate);
+        samplesGenerated += covered;
+        if (g_cueRate > 1) {
+            g_cueWindowRemaining -= covered;
+        }
+        if (covered < toGenerate) {
+            ended = true;
+            break;
+        }
+    }
+
+    {
+        TraceSpan span(g_trace, "opl", samplesGenerated);
+        g_qualityOpl->render(out, samplesGenerated);
+    }
+
+    *samplesOut = samplesGenerated;
+    g_currentTick = g_regLog.tickAt(g_regLog.position());
+    if (ended) {
+        return 1;
+    }
+
+    g_totalSamplesGenerated = static_cast<unsigned long>(g_regLog.position());
+    g_currentPosition = static_cast<unsigned long>(
+        (static_cast<double>(g_totalSamplesGenerated) / g_sampleRate) * 1000.0
+    );
+    return 0;
+}
+
+// Render up to maxSamples stereo frames through the player and OPL emulator
+// The player runs ahead over the whole block first; its register writes are
+// queued with their frame offsets and the OPL renders the block in one run
+// Uses fixed-point arithmetic to avoid floating-point precision drift
+// Returns 0 while playing, 1 when song ends; *samplesOut receives frames written
+static int renderSamples(int16_t* out, int maxSamples, int* samplesOut)
+{
+    patternStateBegin(g_pattern);
+    if (g_regLog.active()) {
+        return renderRegLog(out, maxSamples, samplesOut);
+    }
+
+    int samplesGenerated = 0;
+    unsigned long samplesSkipped = 0;
+    int result = 0;
+
+    g_qualityOpl->beginQueue();
+
+    while (samplesGenerated < maxSamples) {
+        // Cue mode: skip ahead once the audible window is used up
+        if (g_cueRate > 1 && g_cueWindowRemaining <= 0) {
+            unsigned long skipped = 0;
+            bool stillPlaying = skipCueTicks(&skipped);
+            samplesSkipped += skipped;
+            if (!stillPlaying) {
+                result = 1;
+                break;
+            }
+            recordPatternState(samplesGenerated);
+            g_cueWindowRemaining = CUE_WINDOW_SAMPLES;
+        }
+
+        // Samples left in the current tick (integer part of the fixed-point accumulator)
+        int samplesToGenerate = static_cast<int>(g_sampleAccumulatorFixed >> FIXED_POINT_SHIFT);
+        if (samplesToGenerate > 0) {
+            int remaining = maxSamples - samplesGenerated;
+            int toGenerate = samplesToGenerate < remaining ? samplesToGenerate : remaining;
+            if (g_cueRate > 1 && toGenerate > g_cueWindowRemaining) {
+                toGenerate = g_cueWindowRemaining;
+            }
+
+            g_qualityOpl->advanceQueue(toGenerate);
+            samplesGenerated += toGenerate;
+            // Subtract using fixed-point (toGenerate << FIXED_POINT_SHIFT)
+            g_sampleAccumulatorFixed -= (static_cast<uint64_t>(toGenerate) << FIXED_POINT_SHIFT);
+            if (g_cueRate > 1) {
+                g_cueWindowRemaining -= toGenerate;
+            }
+        }
+
+        // Process next tick once all samples of the current one are queued
+        if (samplesGenerated < maxSamples && (g_sampleAccumulatorFixed >> FIXED_POINT_SHIFT) == 0) {
+            bool stillPlaying = tickPlayer(); // ISS 가사 동기화용 틱 증가
+
+            if (!stillPlaying) {
+                // Song ended
+                result = 1;
+                break;
+            }
+            recordPatternState(samplesGenerated);
+
+            // Get samples per tick AFTER update (refresh rate may change)
+            // Integer addition - no precision loss
+            g_sampleAccumulatorFixed += getSamplesPerTickFixed();
+        }
+    }
+
+    // Generate audio through OPL
+    {
+        TraceSpan span(g_trace, "opl", samplesGenerated);
+        g_qualityOpl->render(out, samplesGenerated);
+    }
+
+    if (result != 0) {
+        *samplesOut = samplesGenerated;
+        return result;
+    }
+
+    // Update position estimate (in ms) - skipped cue content counts as played
+    g_totalSamplesGenerated += samplesGenerated + samplesSkipped;
+    g_currentPosition = static_cast<unsigned long>(
+        (static_cast<double>(g_totalSamplesGenerated) / g_sampleRate) * 1000.0
+    );
+
+    *samplesOut = samplesGenerated;
+    return 0;
+}
+
+// Publish position, pattern position and channel levels for JS readers
+static void publishState()
+{
+    PublishedState state = {};
+    state.positionMs = static_cast<uint32_t>(g_currentPosition);
+    state.tick = static_cast<uint32_t>(g_currentTick);
+    state.order = g_player ? static_cast<int32_t>(g_player->getorder()) : -1;
+    state.pattern = g_player ? static_cast<int32_t>(g_player->getpattern()) : -1;
+    state.row = g_player ? static_cast<int32_t>(g_player->getrow()) : -1;
+    state.loopCount = g_loopCount;
+    // Levels are tapped from the Nuked core; the cheaper cores report none
+    state.channelCount = g_opl && g_qualityOpl->usesNuked() ? CChanopl::CHANNELS : 0;
+    for (uint32_t ch = 0; ch < state.channelCount; ch++) {
+        // While streaming from the loop cache the chip is not clocked and levels hold
+        state.levels[ch] = g_opl->channelLevel(static_cast<int>(ch));
+    }
+    statePublish(g_publishedState, state);
+}
+
+// Start the register log of a subsong, from a freshly initialized chip
+static void beginRegLog(int subsong)
+{
+    uint64_t maxFrames = static_cast<uint64_t>(EXPORT_MAX_LENGTH_MS) * g_sampleRate / 1000;
+    if (g_regLog.begin(g_mainFilename, g_memProvider, subsong, g_sampleRate, maxFrames)) {
+        g_regLog.rewind(g_qualityOpl);
+    }
+}
+
+// Restart the song (or a subsong) from its first tick
+static void rewindSong(int subsong)
+{
+    patternStateInvalidate(g_pattern);
+    if (g_regLog.active()) {
+        g_regLog.rewind(g_qualityOpl);
+    } else {
+        g_player->rewind(subsong);
+    }
+}
+
+// Move the song to a position; the caller handles the loop cache
+static void seekSong(unsigned long ms)
+{
+    patternStateInvalidate(g_pattern);
+    if (g_regLog.active()) {
+        g_regLog.seek(g_qualityOpl, static_cast<uint64_t>(ms) * g_sampleRate / 1000);
+        g_totalSamplesGenerated = static_cast<unsigned long>(g_regLog.position());
+        g_currentTick = g_regLog.tickAt(g_regLog.position());
+    } else {
+        g_player->seek(ms);
+    }
+    g_sampleAccumulatorFixed = 0;
+}
+
+// Render one playback block into the audio buffer
+static int renderLive()
+{
+    int samplesGenerated = 0;
+    int result = renderSamples(g_audioBuffer, AUDIO_BUFFER_SIZE, &samplesGenerated);
+    g_audioBufferLength = samplesGenerated * 2 * sizeof(int16_t);
+    return result;
+}
+
+// Drop the loop cache and any recording in progress
+static void freeLoopCache()
+{
+    std::vector<int16_t>().swap(g_loopCache);
+    std::vector<unsigned long>().swap(g_loopCacheTicks);
+    g_loopCacheRecording = false;
+    g_loopCacheComplete = false;
+    g_loopCachePlaying = false;
+    g_loopCacheReadPos = 0;
+}
+
+// Start recording a pass from the start of the song if it fits the budget
+static void startLoopCacheRecording()
+{
+    freeLoopCache();
+    if (g_loopCacheBudget == 0 || g_cueRate > 1) {
+        return;
+    }
+
+    // VGM loops natively while the loop flag is set, so a pass never ends
+    std::string lowerName = toLower(g_mainFilename);
+    size_t extPos = lowerName.find_last_of('.');
+    std::string ext = extPos != std::string::npos ? lowerName.substr(extPos) : "";
+    if (g_loopEnabled && (ext == ".vgm" || ext == ".vgz")) {
+        return;
+    }
+
+    size_t estimatedBytes = static_cast<size_t>(
+        static_cast<double>(g_maxPosition) / 1000.0 * g_sampleRate) * 2 * sizeof(int16_t);
+    if (estimatedBytes > g_loopCacheBudget) {
+        return;
+    }
+
+    g_loopCache.reserve(estimatedBytes / sizeof(int16_t));
+    g_loopCacheRecording = true;
+    g_loopCacheLevel = g_quality.level;
+}
+
+// Append the block just rendered to the recording
+static void recordLoopCache(bool songEnded)
+{
+    size_t samples = g_audioBufferLength / sizeof(int16_t);
+    if ((g_loopCache.size() + samples) * sizeof(int16_t) > g_loopCacheBudget) {
+        freeLoopCache();
+        return;
+    }
+
+    g_loopCache.insert(g_loopCache.end(), g_audioBuffer, g_audioBuffer + samples);
+    g_loopCacheTicks.push_back(g_currentTick);
+
+    if (songEnded) {
+        g_loopCacheRecording = false;
+        g_loopCacheComplete = true;
+        g_loopCache.shrink_to_fit();
+    }
+}
+
+// Hand the current quality level to the OPL proxy
+// A recording spanning a level change would splice the output of two cores,
+// and a cache recorded at a lower quality than the current one would keep
+// replaying it, so both are dropped
+static void applyQualityLevel()
+{
+    if (g_qualityOpl) {
+        g_qualityOpl->setLevel(g_quality.level);
+    }
+    if (g_loopCacheRecording && g_quality.level != g_loopCacheLevel) {
+        freeLoopCache();
+    } else if (g_loopCacheComplete && g_quality.level < g_loopCacheLevel) {
+        if (g_loopCachePlaying && g_player) {
+            // Continue live from where the cache left off
+            seekSong(g_currentPosition);
+        }
+        freeLoopCache();
+    }
+}
+
+// Stream one block from the loop cache instead of synthesizing it
+// Returns 0 while playing, 1 at the end of the cached pass
+static int playLoopCache()
+{
+    size_t totalFrames = g_loopCache.size() / 2;
+    patternStateBegin(g_pattern);    // No ticks run, so no pattern changes
+
+    // Cue mode: skipping ahead is just moving the read position
+    if (g_cueRate > 1 && g_cueWindowRemaining <= 0) {
+        g_loopCacheReadPos += static_cast<size_t>(CUE_WINDOW_SAMPLES) * (g_cueRate - 1);
+        g_cueWindowRemaining = CUE_WINDOW_SAMPLES;
+    }
+    if (g_loopCacheReadPos > totalFrames) {
+        g_loopCacheReadPos = totalFrames;
+    }
+
+    size_t frames = totalFrames - g_loopCacheReadPos;
+    if (frames > static_cast<size_t>(AUDIO_BUFFER_SIZE)) {
+        frames = AUDIO_BUFFER_SIZE;
+    }
+    if (g_cueRate > 1) {
+        if (frames > static_cast<size_t>(g_cueWindowRemaining)) {
+            frames = g_cueWindowRemaining;
+        }
+        g_cueWindowRemaining -= static_cast<int>(frames);
+    }
+
+    memcpy(g_audioBuffer, &g_loopCache[g_loopCacheReadPos * 2], frames * 2 * sizeof(int16_t));
+    g_loopCacheReadPos += frames;
+    g_audioBufferLength = static_cast<int>(frames * 2 * sizeof(int16_t));
+
+    g_totalSamplesGenerated = g_loopCacheReadPos;
+    g_currentPosition = static_cast<unsigned long>(
+        (static_cast<double>(g_totalSamplesGenerated) / g_sampleRate) * 1000.0
+    );
+    if (g_loopCacheReadPos > 0 && !g_loopCacheTicks.empty()) {
+        size_t block = (g_loopCacheReadPos - 1) / AUDIO_BUFFER_SIZE;
+        if (block >= g_loopCacheTicks.size()) block = g_loopCacheTicks.size() - 1;
+        g_currentTick = g_loopCacheTicks[block];
+    } else {
+        g_currentTick = 0;
+    }
+
+    return g_loopCacheReadPos >= totalFrames ? 1 : 0;
+}
+
+// Release the overview analysis result
+static void freeOverview()
+{
+    if (g_overviewBuffer) {
+        delete[] g_overviewBuffer;
+        g_overviewBuffer = nullptr;
+    }
+    g_overviewBuckets = 0;
+}
+
+// Put back the loop and quality settings emu_export_begin() replaced
+static void restoreExportSettings()
+{
+    g_loopEnabled = g_exportSavedLoopEnabled;
+    qualityConfigure(g_quality, g_exportSavedAdaptive, CQualityopl::LEVELS - 1);
+    qualitySetLevel(g_quality, g_exportSavedQualityLevel);
+    applyQualityLevel();
+}
+
+// Drop an export that failed part way
+static void abortExport()
+{
+    if (g_exportActive) {
+        g_exportActive = false;
+        restoreExportSettings();
+    }
+    std::vector<uint8_t>().swap(g_exportBuffer);
+    std::vector<int16_t>().swap(g_exportMixScratch);
+    g_exportFrames = 0;
+}
+
+// emu_export_begin without the exception boundary
+static int exportBegin(int stems)
+{
+    if (!g_player || !g_opl) {
+        return -1;
+    }
+    abortExport();
+
+    // From here on abortExport() / emu_export_end() restore these
+    g_exportSavedLoopEnabled = g_loopEnabled;
+    g_exportSavedAdaptive = g_quality.enabled;
+    g_exportSavedQualityLevel = g_quality.level;
+    g_exportActive = true;
+    g_loopEnabled = false;
+    g_cueRate = 1;
+    freeLoopCache();
+
+    // Exports are not real-time: always render (and tap stems) at full quality
+    qualityConfigure(g_quality, false, CQualityopl::LEVELS - 1);
+    applyQualityLevel();
+
+    rewindSong(g_currentSubsong);
+    g_sampleAccumulatorFixed = 0;
+    g_totalSamplesGenerated = 0;
+    g_currentTick = 0;
+    g_currentPosition = 0;
+
+    // Expected length drives progress; allow a second of slack before cutting
+    g_exportExpectedFrames = static_cast<uint64_t>(g_maxPosition) * g_sampleRate / 1000;
+    g_exportMaxFrames = static_cast<uint64_t>(EXPORT_MAX_LENGTH_MS) * g_sampleRate / 1000;
+    if (g_exportExpectedFrames > 0 && g_exportExpectedFrames + g_sampleRate < g_exportMaxFrames) {
+        g_exportMaxFrames = g_exportExpectedFrames + g_sampleRate;
+    }
+    g_exportFrames = 0;
+    g_exportChannels = stems ? CChanopl::CHANNELS : 2;
+
+    size_t headerSize = wavHeaderSize(g_exportChannels);
+    g_exportBuffer.assign(headerSize, 0);
+    g_exportBuffer.reserve(headerSize + g_exportExpectedFrames * g_exportChannels * sizeof(int16_t));
+    return 0;
+}
+
+// emu_export_render without the exception boundary
+static int exportRender(int maxFrames)
+{
+    if (!g_exportActive || maxFrames <= 0) {
+        return -1;
+    }
+
+    TraceSpan span(g_trace, "export", maxFrames);
+
+    uint64_t remaining = g_exportMaxFrames - g_exportFrames;
+    if (static_cast<uint64_t>(maxFrames) > remaining) {
+        maxFrames = static_cast<int>(remaining);
+    }
+
+    size_t frameBytes = static_cast<size_t>(g_exportChannels) * sizeof(int16_t);
+    size_t offset = g_exportBuffer.size();
+    g_exportBuffer.resize(offset + static_cast<size_t>(maxFrames) * frameBytes);
+    int16_t* dest = reinterpret_cast<int16_t*>(&g_exportBuffer[offset]);
+
+    int frames = 0;
+    int ended;
+    if (g_exportChannels == 2) {
+        ended = renderSamples(dest, maxFrames, &frames);
+    } else {
+        g_exportMixScratch.resize(static_cast<size_t>(maxFrames) * 2);
+        g_opl->setStemOutput(dest);
+        ended = renderSamples(g_exportMixScratch.data(), maxFrames, &frames);
+        g_opl->setStemOutput(nullptr);
+    }
+    g_exportBuffer.resize(offset + static_cast<size_t>(frames) * frameBytes);
+    g_exportFrames += frames;
+
+    if (ended || g_exportFrames >= g_exportMaxFrames) {
+        uint32_t dataBytes = static_cast<uint32_t>(g_exportBuffer.size() - wavHeaderSize(g_exportChannels));
+        writeWavHeader(g_exportBuffer.data(), g_sampleRate, g_exportChannels, 16, dataBytes);
+        g_exportActive = false;
+        restoreExportSettings();
+        return 1000;
+    }
+
+    if (g_exportExpectedFrames == 0) {
+        return 0;
+    }
+    uint64_t progress = g_exportFrames * 1000 / g_exportExpectedFrames;
+    return progress > 999 ? 999 : static_cast<int>(progress);
+}
+
+// emu_render_overview without the exception boundary
+static int renderOverview(int buckets)
+{
+    if (!g_player || g_mainFilename.empty() || buckets <= 0 || buckets > OVERVIEW_MAX_BUCKETS) {
+        return -1;
+    }
+
+    unsigned long lengthMs = g_maxPosition;
+    if (lengthMs == 0) {
+        return -1;
+    }
+    TraceSpan span(g_trace, "overview", buckets);
+    if (lengthMs > OVERVIEW_MAX_LENGTH_MS) {
+        lengthMs = OVERVIEW_MAX_LENGTH_MS;
+    }
+
+    CEmuopl opl(OVERVIEW_SAMPLE_RATE, true, false);
+    opl.init();
+    std::unique_ptr<CPlayer> player(CAdPlug::factory(g_mainFilename, &opl,
+                                                     CAdPlug::players, g_memProvider));
+    if (!player) {
+        return -1;
+    }
+    player->rewind(g_currentSubsong);
+
+    freeOverview();
+    g_overviewBuffer = new float[buckets * 3];
+    g_overviewBuckets = buckets;
+
+    uint64_t totalSamples = static_cast<uint64_t>(lengthMs) * OVERVIEW_SAMPLE_RATE / 1000;
+    uint64_t samplesPerBucket = (totalSamples + buckets - 1) / buckets;
+    if (samplesPerBucket == 0) samplesPerBucket = 1;
+
+    int16_t buf[AUDIO_BUFFER_SIZE];
+    uint64_t rendered = 0;
+    uint64_t accumulatorFixed = 0;
+    int bucket = 0;
+    int bucketMin = 0, bucketMax = 0;
+    double bucketSumSq = 0.0;
+    uint64_t bucketCount = 0;
+    bool playing = true;
+
+    auto flushBucket = [&]() {
+        if (bucket >= buckets) return;
+        float* out = &g_overviewBuffer[bucket * 3];
+        out[0] = bucketMin / 32768.0f;
+        out[1] = bucketMax / 32768.0f;
+        out[2] = bucketCount > 0
+            ? static_cast<float>(sqrt(bucketSumSq / bucketCount) / 32768.0)
+            : 0.0f;
+        bucket++;
+        bucketMin = bucketMax = 0;
+        bucketSumSq = 0.0;
+        bucketCount = 0;
+    };
+
+    while (playing && rendered < totalSamples) {
+        int samplesToGenerate = static_cast<int>(accumulatorFixed >> FIXED_POINT_SHIFT);
+        if (samplesToGenerate > 0) {
+            int toGenerate = samplesToGenerate < AUDIO_BUFFER_SIZE ? samplesToGenerate : AUDIO_BUFFER_SIZE;
+            opl.update(buf, toGenerate);
+            accumulatorFixed -= (static_cast<uint64_t>(toGenerate) << FIXED_POINT_SHIFT);
+
+            for (int i = 0; i < toGenerate && rendered < totalSamples; i++, rendered++) {
+                int v = buf[i];
+                if (v < bucketMin) bucketMin = v;
+                if (v > bucketMax) bucketMax = v;
+                bucketSumSq += static_cast<double>(v) * v;
+                bucketCount++;
+                if (bucketCount >= samplesPerBucket) {
+                    flushBucket();
+                }
+            }
+            continue;
+        }
+
+        playing = player->update();
+        accumulatorFixed += samplesPerTickFixed(player.get(), OVERVIEW_SAMPLE_RATE);
+    }
+
+    // Flush the partial bucket and zero any buckets past the end of the song
+    if (bucketCount > 0) {
+        flushBucket();
+    }
+    while (bucket < buckets) {
+        flushBucket();
+    }
+
+    return 0;
+}
+
 extern "C" {
 
 /**
@@ -168,6 +839,11 @@ int emu_init(int sampleRate)
         delete g_player;  // This should close all streams via file provider
         g_player = nullptr;
     }
+    g_regLog.clear();
+    if (g_qualityOpl) {
+        delete g_qualityOpl;
+        g_qualityOpl = nullptr;
+    }
     if (g_opl) {
         delete g_opl;
         g_opl = nullptr;
@@ -176,6 +852,9 @@ int emu_init(int sampleRate)
         delete[] g_audioBuffer;
         g_audioBuffer = nullptr;
     }
+    freeOverview();
+    freeLoopCache();
+    g_mainFilename.clear();
 
     // Note: Don't call clearBuffers() here - close() handles buffer cleanup
     // Calling clearBuffers() while streams might still be open causes garbage audio
@@ -189,11 +868,18 @@ int emu_init(int sampleRate)
     g_sampleRate = sampleRate > 0 ? sampleRate : 49716;
 
     // Create OPL emulator
-    g_opl = new CNemuopl(g_sampleRate);
+    g_opl = new CChanopl(g_sampleRate);
     if (!g_opl) {
         return -1;
     }
     g_opl->init();
+    g_opl->setScopeOutput(g_scopeRing.data(), g_scopeFrames, g_scopeDecimation);
+    g_opl->setStereoWidth(g_stereoWidth);
+
+    // Keep the quality level reached so far; the device did not get faster
+    g_qualityOpl = new CQualityopl(g_opl, g_sampleRate);
+    g_qualityOpl->setLevel(g_quality.level);
+    g_qualityOpl->init();
 
     // Allocate audio buffer (stereo) - zero-initialized to prevent garbage audio
     g_audioBuffer = new int16_t[AUDIO_BUFFER_SIZE * 2]();
@@ -205,6 +891,8 @@ int emu_init(int sampleRate)
     g_sampleAccumulatorFixed = 0;
     g_totalSamplesGenerated = 0;
     g_currentTick = 0;
+    g_cueRate = 1;
+    g_cueWindowRemaining = 0;
 
     return 0;
 }
@@ -218,6 +906,11 @@ void emu_teardown()
         delete g_player;  // This should close all streams via file provider
         g_player = nullptr;
     }
+    g_regLog.clear();
+    if (g_qualityOpl) {
+        delete g_qualityOpl;
+        g_qualityOpl = nullptr;
+    }
     if (g_opl) {
         delete g_opl;
         g_opl = nullptr;
@@ -226,6 +919,9 @@ void emu_teardown()
         delete[] g_audioBuffer;
         g_audioBuffer = nullptr;
     }
+    freeOverview();
+    freeLoopCache();
+    g_mainFilename.clear();
 
     // Note: Don't call clearBuffers() here - close() handles buffer cleanup
 
@@ -235,6 +931,9 @@ void emu_teardown()
     }
     g_files.clear();
 
+    std::vector<uint8_t>().swap(g_exportBuffer);
+    g_exportActive = false;
+
     g_audioBufferLength = 0;
     g_currentPosition = 0;
     g_maxPosition = 0;
@@ -287,21 +986,33 @@ int emu_load_file(const char* filename, const uint8_t* data, int size)
         delete g_player;
         g_player = nullptr;
     }
+    g_regLog.clear();
+    // The cached song must not outlive it, even if the new one fails to load
+    freeLoopCache();
 
     // Re-initialize OPL
-    g_opl->init();
+    g_qualityOpl->init();
 
     // Reset timing state
     g_sampleAccumulatorFixed = 0;
     g_totalSamplesGenerated = 0;
     g_currentTick = 0;
+    g_currentSubsong = 0;
+    freeOverview();
+    patternStateInvalidate(g_pattern);
 
     // Add main file to storage
     emu_add_file(filename, data, size);
+    g_mainFilename = filename;
+
+    TraceSpan loadSpan(g_trace, "load", size);
 
     // Use AdPlug factory to create appropriate player
-    g_player = CAdPlug::factory(std::string(filename), g_opl,
-                                 CAdPlug::players, g_memProvider);
+    {
+        TraceSpan span(g_trace, "factory");
+        g_player = CAdPlug::factory(std::string(filename), g_qualityOpl,
+                                     CAdPlug::players, g_memProvider);
+    }
 
     if (!g_player) {
         return -1;
@@ -313,9 +1024,23 @@ int emu_load_file(const char* filename, const uint8_t* data, int size)
     strncpy(g_type, g_player->gettype().c_str(), sizeof(g_type) - 1);
     strncpy(g_desc, g_player->getdesc().c_str(), sizeof(g_desc) - 1);
 
+    // Register dumps, ROL and MUS/IMS play from the register log, which
+    // records as playback goes
+    if (CRegLog::handles(g_player)) {
+        TraceSpan span(g_trace, "reglog");
+        beginRegLog(0);
+    }
+
     // Calculate song length
-    g_maxPosition = g_player->songlength();
+    {
+        TraceSpan span(g_trace, "songlength");
+        g_maxPosition = g_player->songlength();
+    }
     g_currentPosition = 0;
+    g_loopCount = 0;
+
+    startLoopCacheRecording();
+    publishState();
 
     return 0;
 }
@@ -332,49 +1057,30 @@ int emu_compute_audio_samples()
         return 1;
     }
 
-    int samplesGenerated = 0;
-    int maxSamples = AUDIO_BUFFER_SIZE;
-
-    while (samplesGenerated < maxSamples) {
-        // Generate samples for current tick (extract integer part from fixed-point)
-        int samplesToGenerate = static_cast<int>(g_sampleAccumulatorFixed >> FIXED_POINT_SHIFT);
-        if (samplesToGenerate > 0) {
-            int remaining = maxSamples - samplesGenerated;
-            int toGenerate = samplesToGenerate < remaining ? samplesToGenerate : remaining;
-
-            // Generate audio through OPL
-            g_opl->update(&g_audioBuffer[samplesGenerated * 2], toGenerate);
-
-            samplesGenerated += toGenerate;
-            // Subtract using fixed-point (toGenerate << FIXED_POINT_SHIFT)
-            g_sampleAccumulatorFixed -= (static_cast<uint64_t>(toGenerate) << FIXED_POINT_SHIFT);
-        }
-
-        // Process next tick
-        if (samplesGenerated < maxSamples) {
-            bool stillPlaying = g_player->update();
-            g_currentTick++; // ISS 가사 동기화용 틱 증가
-
-            if (!stillPlaying) {
-                // Song ended
-                g_audioBufferLength = samplesGenerated * 2 * sizeof(int16_t);
-                return 1;
-            }
-
-            // Get samples per tick AFTER update (refresh rate may change)
-            // Integer addition - no precision loss
-            g_sampleAccumulatorFixed += getSamplesPerTickFixed();
+    TraceSpan span(g_trace, "render", AUDIO_BUFFER_SIZE);
+    double startUs = traceNowUs();
+
+    int result;
+    bool live = !g_loopCachePlaying;
+    if (!live) {
+        result = playLoopCache();
+    } else {
+        result = renderLive();
+        if (g_loopCacheRecording) {
+            recordLoopCache(result != 0);
         }
     }
 
-    // Update position estimate (in ms)
-    g_totalSamplesGenerated += samplesGenerated;
-    g_currentPosition = static_cast<unsigned long>(
-        (static_cast<double>(g_totalSamplesGenerated) / g_sampleRate) * 1000.0
-    );
+    double renderUs = traceNowUs() - startUs;
+    int frames = g_audioBufferLength / static_cast<int>(2 * sizeof(int16_t));
+    renderStatsRecord(g_renderStats, renderUs, frames, g_sampleRate);
 
-    g_audioBufferLength = samplesGenerated * 2 * sizeof(int16_t);
-    return 0;
+    // Only synthesized blocks say anything about the cost of the current level
+    if (live && qualityRecord(g_quality, renderUs, frames, g_sampleRate)) {
+        applyQualityLevel();
+    }
+    publishState();
+    return result;
 }
 
 /**
@@ -416,9 +1122,24 @@ unsigned long emu_get_max_position()
  */
 void emu_seek_position(unsigned long ms)
 {
+    TraceSpan span(g_trace, "seek", static_cast<int32_t>(ms));
+
+    if (g_loopCacheComplete) {
+        // Seek inside the cached pass
+        g_loopCachePlaying = true;
+        g_loopCacheReadPos = static_cast<size_t>(
+            static_cast<double>(ms) / 1000.0 * g_sampleRate);
+        g_currentPosition = ms;
+        publishState();
+        return;
+    }
+
     if (g_player) {
-        g_player->seek(ms);
+        // A recording is only valid as one continuous pass from the start
+        freeLoopCache();
+        seekSong(ms);
         g_currentPosition = ms;
+        publishState();
     }
 }
 
@@ -448,9 +1169,19 @@ int emu_get_subsong_count()
 void emu_set_subsong(int subsong)
 {
     if (g_player) {
-        g_player->rewind(subsong);
+        // The log holds one subsong; record the new one instead
+        if (g_regLog.active()) {
+            beginRegLog(subsong);
+        }
+        rewindSong(subsong);
         g_maxPosition = g_player->songlength(subsong);
         g_currentPosition = 0;
+        g_currentSubsong = subsong;
+        freeOverview();
+        g_sampleAccumulatorFixed = 0;
+        g_totalSamplesGenerated = 0;
+        g_currentTick = 0;
+        startLoopCacheRecording();
     }
 }
 
@@ -467,12 +1198,27 @@ int emu_get_sample_rate()
  */
 void emu_rewind()
 {
+    if (g_loopCacheComplete) {
+        // Stream later passes from the cache
+        g_loopCachePlaying = true;
+        g_loopCacheReadPos = 0;
+        g_currentPosition = 0;
+        g_currentTick = 0;
+        g_totalSamplesGenerated = 0;
+        g_loopCount++;
+        publishState();
+        return;
+    }
+
     if (g_player) {
-        g_player->rewind(-1);
+        rewindSong(-1);
         g_currentPosition = 0;
         g_currentTick = 0;
         g_sampleAccumulatorFixed = 0;
         g_totalSamplesGenerated = 0;
+        g_loopCount++;
+        startLoopCacheRecording();
+        publishState();
     }
 }
 
@@ -492,6 +1238,8 @@ unsigned long emu_get_current_tick()
 float emu_get_refresh_rate()
 {
     if (!g_player) return 70.0f;
+    // The log's player has finished at load; tempo is looked up by position
+    if (g_regLog.active()) return g_regLog.refreshAt(g_regLog.position());
     float rate = g_player->getrefresh();
     return rate > 0 ? rate : 70.0f;
 }
@@ -514,4 +1262,374 @@ int emu_get_loop_enabled()
     return g_loopEnabled ? 1 : 0;
 }
 
+/**
+ * Set fast-forward cue rate
+ * Content advances at the given multiple while only short windows are synthesized
+ * @param rate 1 = normal playback, 2-16 = cue playback
+ */
+void emu_set_cue_rate(int rate)
+{
+    if (rate < 1) rate = 1;
+    if (rate > CUE_MAX_RATE) rate = CUE_MAX_RATE;
+    g_cueRate = rate;
+    g_cueWindowRemaining = CUE_WINDOW_SAMPLES;
+
+    // Cue skips would leave holes in a recording
+    if (rate > 1 && g_loopCacheRecording) {
+        freeLoopCache();
+    }
+}
+
+/**
+ * Get fast-forward cue rate
+ * @return 1 for normal playback, otherwise the cue multiple
+ */
+int emu_get_cue_rate()
+{
+    return g_cueRate;
+}
+
+/**
+ * Set memory budget for the loop cache
+ * The next pass from the start of the song is recorded if it fits,
+ * and later rewinds and seeks stream from memory
+ * @param bytes Budget in bytes, 0 to disable and free the cache
+ */
+void emu_set_loop_cache_budget(int bytes)
+{
+    g_loopCacheBudget = bytes > 0 ? static_cast<size_t>(bytes) : 0;
+
+    if (g_loopCacheBudget == 0 || g_loopCache.size() * sizeof(int16_t) > g_loopCacheBudget) {
+        if (g_loopCachePlaying && g_player) {
+            // Continue live from where the cache left off
+            seekSong(g_currentPosition);
+        }
+        freeLoopCache();
+    }
+}
+
+/**
+ * Check whether playback is streaming from the loop cache
+ * @return 1 if streaming from cache, 0 if synthesizing
+ */
+int emu_is_loop_cache_playing()
+{
+    return g_loopCachePlaying ? 1 : 0;
+}
+
+/**
+ * Start an offline export of the loaded song to WAV
+ * Rewinds the song and renders at full quality without looping; the loop
+ * and adaptive quality settings come back on completion or emu_export_end()
+ * Intended for a dedicated module instance (e.g. in a Web Worker)
+ * @param stems 0 = stereo mix, 1 = one WAV channel per OPL channel (18 channels)
+ * @return 0 on success, -1 on failure
+ */
+int emu_export_begin(int stems)
+{
+    try {
+        return exportBegin(stems);
+    } catch (...) {
+        // Out of memory for the WAV buffer
+        abortExport();
+        return -1;
+    }
+}
+
+/**
+ * Render the next part of the export in one large call
+ * Stems are tapped from the OPL core in the same synthesis pass as the mix
+ * @param maxFrames Maximum frames to render in this call
+ * @return Progress 0-999 while rendering, 1000 when the WAV is complete, -1 on error
+ */
+int emu_export_render(int maxFrames)
+{
+    try {
+        return exportRender(maxFrames);
+    } catch (...) {
+        abortExport();
+        return -1;
+    }
+}
+
+/**
+ * Get pointer to the exported WAV file
+ */
+uint8_t* emu_export_get_buffer()
+{
+    return g_exportBuffer.empty() ? nullptr : g_exportBuffer.data();
+}
+
+/**
+ * Get size of the exported WAV file in bytes
+ */
+int emu_export_get_length()
+{
+    return static_cast<int>(g_exportBuffer.size());
+}
+
+/**
+ * Release export memory, restore playback settings and rewind
+ */
+void emu_export_end()
+{
+    if (g_exportActive) {
+        g_exportActive = false;
+        restoreExportSettings();
+    }
+    std::vector<uint8_t>().swap(g_exportBuffer);
+    std::vector<int16_t>().swap(g_exportMixScratch);
+    g_exportFrames = 0;
+
+    if (g_player) {
+        rewindSong(g_currentSubsong);
+        g_sampleAccumulatorFixed = 0;
+        g_totalSamplesGenerated = 0;
+        g_currentTick = 0;
+        g_currentPosition = 0;
+    }
+}
+
+/**
+ * Render a min/max/RMS envelope of the whole song (seek-bar waveform)
+ * Opens a second player on the loaded file with the MAME OPL core at a low
+ * mono sample rate, so the playback state is left untouched
+ * @param buckets Number of envelope buckets across the song length
+ * @return 0 on success, -1 on failure
+ */
+int emu_render_overview(int buckets)
+{
+    // VGM native loop would never end - analyse a single pass only
+    bool savedLoopEnabled = g_loopEnabled;
+    g_loopEnabled = false;
+
+    int result;
+    try {
+        result = renderOverview(buckets);
+    } catch (...) {
+        // Out of memory for the envelope or the player; both are released on unwind
+        freeOverview();
+        result = -1;
+    }
+    g_loopEnabled = savedLoopEnabled;
+    return result;
+}
+
+/**
+ * Get pointer to the overview result
+ * @return Pointer to buckets * 3 floats (min, max, rms per bucket), or null
+ */
+float* emu_get_overview_buffer()
+{
+    return g_overviewBuffer;
+}
+
+/**
+ * Get number of buckets in the overview result
+ */
+int emu_get_overview_buckets()
+{
+    return g_overviewBuckets;
+}
+
+/**
+ * Get the published playback state block
+ * Updated once per render call (and on load/seek/rewind); see
+ * state_block.h for the layout
+ * @return Pointer to the state block
+ */
+PublishedState* emu_get_state_block()
+{
+    return &g_publishedState;
+}
+
+/**
+ * Start or stop per-channel oscilloscope capture
+ * During synthesis every decimation-th output frame of each OPL channel is
+ * written to a ring, at no extra synthesis cost. Captured rate is
+ * sampleRate / decimation. Nothing is captured while a cheaper quality
+ * level's core or the loop cache produces the audio.
+ * @param decimation Output samples per captured frame (1-64, e.g. 8)
+ * @param frames Ring capacity in frames, 0 = stop and free
+ * @return 0 on success, -1 on invalid arguments
+ */
+int emu_scope_enable(int decimation, int frames)
+{
+    if (frames < 0 || frames > SCOPE_MAX_FRAMES ||
+        decimation < 1 || decimation > SCOPE_MAX_DECIMATION) {
+        return -1;
+    }
+
+    if (frames == 0) {
+        std::vector<int16_t>().swap(g_scopeRing);
+    } else {
+        g_scopeRing.assign(static_cast<size_t>(frames) * CChanopl::CHANNELS, 0);
+    }
+    g_scopeFrames = frames;
+    g_scopeDecimation = decimation;
+    if (g_opl) {
+        g_opl->setScopeOutput(g_scopeRing.data(), g_scopeFrames, g_scopeDecimation);
+    }
+    return 0;
+}
+
+/**
+ * Get pointer to the oscilloscope ring
+ * @return frames * 18 interleaved int16 values, or null when disabled
+ */
+int16_t* emu_scope_get_buffer()
+{
+    return g_scopeRing.empty() ? nullptr : g_scopeRing.data();
+}
+
+/**
+ * Get the number of frames captured so far
+ * The newest frame is at (count - 1) % frames in the ring
+ * @return Frames written since capture was enabled (wraps at 2^32)
+ */
+uint32_t emu_scope_get_written()
+{
+    return g_opl ? g_opl->scopeWritten() : 0;
+}
+
+/**
+ * Set the pseudo-stereo width for mono (OPL2-mode) songs
+ * Channels are panned alternately left and right from the single chip's
+ * channel taps, so stereo costs the same as mono. Songs that switch on
+ * OPL3 mode keep their own panning, and the cheaper quality levels'
+ * cores play the plain mono mix.
+ * @param percent 0 = off .. 100 = widest
+ */
+void emu_set_stereo_width(int percent)
+{
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+    if (percent == g_stereoWidth) {
+        return;
+    }
+    g_stereoWidth = percent;
+    if (g_opl) {
+        g_opl->setStereoWidth(percent);
+    }
+    // Cached audio was rendered with the old width
+    if (g_loopCachePlaying && g_player) {
+        seekSong(g_currentPosition);
+    }
+    freeLoopCache();
+}
+
+/**
+ * Let render cost drive the quality level
+ * Under sustained load quality steps down: nearest resampling, then the
+ * MAME OPL2 core (songs using only the first register set), then the
+ * DOSBox OPL3 core; it steps back up after a few seconds of headroom
+ * @param enabled 1 to adapt, 0 to return to and stay at full quality
+ */
+void emu_set_adaptive_quality(int enabled)
+{
+    qualityConfigure(g_quality, enabled != 0, CQualityopl::LEVELS - 1);
+    applyQualityLevel();
+}
+
+/**
+ * Force a quality level (adaptation, if enabled, continues from it)
+ * @param level 0 = full quality .. 3 = fast OPL3 core
+ */
+void emu_set_quality_level(int level)
+{
+    g_quality.maxLevel = CQualityopl::LEVELS - 1;
+    qualitySetLevel(g_quality, level);
+    applyQualityLevel();
+}
+
+/**
+ * Get the current quality level
+ * @return 0 = full quality .. 3 = fast OPL3 core
+ */
+int emu_get_quality_level()
+{
+    return g_quality.level;
+}
+
+/**
+ * Get the pattern position changes of the last render call
+ * Layout: count, dropped, then PATTERN_STATE_MAX_CHANGES records of
+ * (frame, order, pattern, row, speed), all 32-bit; see pattern_state.h.
+ * Changes are recorded at the player tick that made them; formats
+ * without patterns report a single unchanging position, and nothing is
+ * recorded while the loop cache or register log plays
+ * @return Pointer to the pattern state block
+ */
+PatternState* emu_get_pattern_state()
+{
+    return &g_pattern.state;
+}
+
+/**
+ * Get render deadline statistics
+ * Layout: calls, over50, over80, over100, worstPermille, then
+ * RENDER_STATS_BUCKETS histogram counts, then OPL writes applied and
+ * dropped as redundant (all uint32, see render_stats.h)
+ * @return Pointer to the statistics block
+ */
+RenderStats* emu_stats_get()
+{
+    if (g_qualityOpl) {
+        g_renderStats.regWrites = g_qualityOpl->writesApplied();
+        g_renderStats.regWritesDropped = g_qualityOpl->writesDropped();
+    }
+    return &g_renderStats;
+}
+
+/**
+ * Reset render deadline statistics
+ */
+void emu_stats_reset()
+{
+    renderStatsReset(g_renderStats);
+    if (g_qualityOpl) {
+        g_qualityOpl->resetWriteStats();
+    }
+}
+
+/**
+ * Start or stop recording the render timeline
+ * Spans: render, update (per tick), opl (per synthesis run),
+ * load/factory/songlength, seek, export (per chunk) and overview
+ * @param capacity Events kept in the ring (oldest dropped), 0 = stop and free
+ */
+void emu_trace_enable(int capacity)
+{
+    try {
+        traceEnable(g_trace, capacity);
+    } catch (...) {
+        traceEnable(g_trace, 0);
+    }
+    if (capacity <= 0) {
+        std::string().swap(g_traceJson);
+    }
+}
+
+/**
+ * Drop recorded spans, keep recording
+ */
+void emu_trace_clear()
+{
+    traceClear(g_trace);
+}
+
+/**
+ * Export recorded spans as Chrome trace-event JSON
+ * @return NUL-terminated JSON, valid until the next export or disable
+ */
+const char* emu_trace_export()
+{
+    try {
+        traceExportJson(g_trace, g_traceJson, "AdPlug");
+    } catch (...) {
+        std::string().swap(g_traceJson);
+    }
+    return g_traceJson.c_str();
+}
+
 } // extern "C"
@@ -1,6 +1,9 @@
 #!/bin/bash
 # AdPlug WASM Build Script
 # Builds adplug 2.4 with NukedOPL for Emscripten/WASM
+#
+# EXCEPTIONS=wasm (default) uses native WASM exception handling;
+# EXCEPTIONS=js uses Emscripten's JS emulation for runtimes without it
 
 set -e
 
@@ -16,7 +19,18 @@ if ! command -v emcc &> /dev/null; then
     exit 1
 fi
 
-echo "=== AdPlug WASM Build ==="
+# adapter.cpp catches allocation failures at its entry points (export, trace)
+EXCEPTIONS="${EXCEPTIONS:-wasm}"
+if [ "$EXCEPTIONS" = "wasm" ]; then
+    EH_FLAGS="-fwasm-exceptions"
+elif [ "$EXCEPTIONS" = "js" ]; then
+    EH_FLAGS="-s DISABLE_EXCEPTION_CATCHING=0"
+else
+    echo "EXCEPTIONS must be wasm or js"
+    exit 1
+fi
+
+echo "=== AdPlug WASM Build ($EXCEPTIONS exceptions) ==="
 echo "Using Emscripten: $(emcc --version | head -1)"
 
 # Create build and dist directories
@@ -28,8 +42,12 @@ CXXFLAGS="-O3 -std=c++17 -DSTDC_HEADERS=1 -Dstricmp=strcasecmp"
 # Note: Paths are relative to build directory
 # -isystem makes binio.h findable with angle brackets
 ADPLUG_INCLUDES="-I../src/src -isystem ../libbinio/src"
+COMMON_INCLUDES="-I../../common"
 BINIO_INCLUDES="-isystem ../libbinio/src"
 
+# Apply local patches to the AdPlug sources
+cp patches/*.cpp src/src/
+
 echo ""
 echo "=== Building libbinio ==="
 cd build
@@ -69,7 +87,10 @@ done
 
 echo ""
 echo "=== Building adapter ==="
-emcc $CXXFLAGS $ADPLUG_INCLUDES -c ../adapter.cpp -o adapter.o
+emcc $CXXFLAGS $ADPLUG_INCLUDES -c ../chanopl.cpp -o chanopl.o
+emcc $CXXFLAGS $ADPLUG_INCLUDES -c ../qualityopl.cpp -o qualityopl.o
+emcc $CXXFLAGS $ADPLUG_INCLUDES -c ../reglog.cpp -o reglog.o
+emcc $CXXFLAGS $EH_FLAGS $ADPLUG_INCLUDES $COMMON_INCLUDES -c ../adapter.cpp -o adapter.o
 
 echo ""
 echo "=== Linking WASM module ==="
@@ -78,13 +99,13 @@ echo "=== Linking WASM module ==="
 OBJECTS="*.o"
 
 # Link into WASM module
-emcc -O3 \
+emcc -O3 $EH_FLAGS \
     $OBJECTS \
     -s WASM=1 \
     -s MODULARIZE=1 \
     -s EXPORT_NAME="AdPlugModule" \
-    -s EXPORTED_FUNCTIONS="['_malloc','_free','_emu_init','_emu_teardown','_emu_add_file','_emu_load_file','_emu_compute_audio_samples','_emu_get_audio_buffer','_emu_get_audio_buffer_length','_emu_get_current_position','_emu_get_max_position','_emu_seek_position','_emu_get_track_info','_emu_get_subsong_count','_emu_set_subsong','_emu_get_sample_rate','_emu_rewind','_emu_get_current_tick','_emu_get_refresh_rate','_emu_set_loop_enabled','_emu_get_loop_enabled']" \
-    -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap','UTF8ToString','stringToUTF8','getValue','setValue','HEAPU8','HEAP16','HEAP32']" \
+    -s EXPORTED_FUNCTIONS="['_malloc','_free','_emu_init','_emu_teardown','_emu_add_file','_emu_load_file','_emu_compute_audio_samples','_emu_get_audio_buffer','_emu_get_audio_buffer_length','_emu_get_current_position','_emu_get_max_position','_emu_seek_position','_emu_get_track_info','_emu_get_subsong_count','_emu_set_subsong','_emu_get_sample_rate','_emu_rewind','_emu_get_current_tick','_emu_get_refresh_rate','_emu_set_loop_enabled','_emu_get_loop_enabled','_emu_render_overview','_emu_get_overview_buffer','_emu_get_overview_buckets','_emu_set_cue_rate','_emu_get_cue_rate','_emu_set_loop_cache_budget','_emu_is_loop_cache_playing','_emu_export_begin','_emu_export_render','_emu_export_get_buffer','_emu_export_get_length','_emu_export_end','_emu_trace_enable','_emu_trace_clear','_emu_trace_export','_emu_stats_get','_emu_stats_reset','_emu_scope_enable','_emu_scope_get_buffer','_emu_scope_get_written','_emu_set_stereo_width','_emu_set_adaptive_quality','_emu_set_quality_level','_emu_get_quality_level','_emu_get_state_block','_emu_get_pattern_state']" \
+    -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap','UTF8ToString','stringToUTF8','getValue','setValue','HEAPU8','HEAP16','HEAP32','HEAPU32','HEAPF32']" \
     -s ALLOW_MEMORY_GROWTH=1 \
     -s INITIAL_MEMORY=16777216 \
     -s STACK_SIZE=1048576 \
@@ -0,0 +1,260 @@
+/*
+ * chanopl.cpp - Nuked OPL3 emulator with per-channel output taps
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#include <cmath>
+
+#include "chanopl.h"
+
+// Envelope attenuation is 9 bits in 0.1875 dB steps; 0x1FF is silence
+static const int EG_SILENT = 0x1FF;
+static const float EG_STEP_DB = 0.1875f;
+
+// Resampler phase fraction bits (RSM_FRAC, private to nukedopl.c)
+static const int NUKED_RSM_FRAC = 10;
+
+// Pseudo-stereo pan positions (-1 left .. 1 right) for channels 0-8;
+// channels 9-17 mirror them. Rhythm channels 6-8 stay near the centre.
+static const float WIDE_PAN[9] = { -1.0f, 1.0f, -0.5f, 0.5f, -0.75f, 0.75f, -0.25f, 0.25f, 0.0f };
+static const int PAN_SHIFT = 12;
+static const int PAN_ONE = 1 << PAN_SHIFT;
+
+static inline short clipSample(int v)
+{
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return static_cast<short>(v);
+}
+
+// OPL3_GenerateResampled without the interpolation: clock the chip up to
+// the output sample and take its latest output as is
+// oldsamples is kept current so switching back to interpolation is seamless
+static inline void generateNearest(opl3_chip* chip, short* buf)
+{
+    while (chip->samplecnt >= chip->rateratio) {
+        chip->oldsamples[0] = chip->samples[0];
+        chip->oldsamples[1] = chip->samples[1];
+        OPL3_Generate(chip, chip->samples);
+        chip->samplecnt -= chip->rateratio;
+    }
+    buf[0] = chip->samples[0];
+    buf[1] = chip->samples[1];
+    chip->samplecnt += 1 << NUKED_RSM_FRAC;
+}
+
+CChanopl::CChanopl(int rate)
+    : m_rate(rate), m_stemOut(nullptr), m_stemOld(), m_stemNew(), m_nearest(false),
+      m_scopeRing(nullptr), m_scopeFrames(0), m_scopeDecimation(1), m_scopePhase(0),
+      m_scopeWritten(0), m_wide(false)
+{
+    setStereoWidth(0);
+    currType = TYPE_OPL3;
+    OPL3_Reset(&m_chip, m_rate);
+}
+
+void CChanopl::init()
+{
+    OPL3_Reset(&m_chip, m_rate);
+    currChip = 0;
+}
+
+void CChanopl::write(int reg, int val)
+{
+    OPL3_WriteRegBuffered(&m_chip, static_cast<uint16_t>((currChip << 8) | reg),
+                          static_cast<uint8_t>(val));
+}
+
+int CChanopl::channelOutput(int ch) const
+{
+    const opl3_channel* channel = &m_chip.channel[ch];
+    return *channel->out[0] + *channel->out[1] + *channel->out[2] + *channel->out[3];
+}
+
+float CChanopl::channelLevel(int ch) const
+{
+    const opl3_channel* channel = &m_chip.channel[ch];
+
+    // Carrier level; with additive connection the modulator is audible too
+    int attenuation = channel->slotz[1]->eg_out;
+    if (channel->con && channel->slotz[0]->eg_out < attenuation) {
+        attenuation = channel->slotz[0]->eg_out;
+    }
+    if (attenuation >= EG_SILENT) {
+        return 0.0f;
+    }
+    return powf(10.0f, -attenuation * EG_STEP_DB / 20.0f);
+}
+
+void CChanopl::setStemOutput(short* stemBuf)
+{
+    if (stemBuf && !m_stemOut) {
+        // Not tracked while stems are off: start from the current outputs
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            m_stemOld[ch] = m_stemNew[ch] = clipSample(channelOutput(ch));
+        }
+    }
+    m_stemOut = stemBuf;
+}
+
+void CChanopl::setScopeOutput(short* ring, int frames, int decimation)
+{
+    m_scopeRing = frames > 0 ? ring : nullptr;
+    m_scopeFrames = frames;
+    m_scopeDecimation = decimation > 0 ? decimation : 1;
+    m_scopePhase = 0;
+    m_scopeWritten = 0;
+}
+
+void CChanopl::captureScopeFrame()
+{
+    short* frame = &m_scopeRing[(m_scopeWritten % m_scopeFrames) * CHANNELS];
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        frame[ch] = clipSample(channelOutput(ch));
+    }
+    m_scopeWritten++;
+}
+
+void CChanopl::setStereoWidth(int percent)
+{
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+    m_wide = percent > 0;
+
+    // Balance law: the centre keeps unity gain on both sides, so the
+    // overall level matches the mono mix
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        float pan = WIDE_PAN[ch % 9] * (ch < 9 ? 1.0f : -1.0f) * percent / 100.0f;
+        m_panLeft[ch] = static_cast<int>((pan > 0 ? 1.0f - pan : 1.0f) * PAN_ONE);
+        m_panRight[ch] = static_cast<int>((pan < 0 ? 1.0f + pan : 1.0f) * PAN_ONE);
+    }
+    m_wideOld[0] = m_wideOld[1] = m_wideNew[0] = m_wideNew[1] = 0;
+}
+
+void CChanopl::generateWide(short* buf)
+{
+    while (m_chip.samplecnt >= m_chip.rateratio) {
+        m_chip.oldsamples[0] = m_chip.samples[0];
+        m_chip.oldsamples[1] = m_chip.samples[1];
+        OPL3_Generate(&m_chip, m_chip.samples);
+        m_chip.samplecnt -= m_chip.rateratio;
+
+        int left = 0;
+        int right = 0;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            int out = channelOutput(ch);
+            left += out * m_panLeft[ch];
+            right += out * m_panRight[ch];
+        }
+        m_wideOld[0] = m_wideNew[0];
+        m_wideOld[1] = m_wideNew[1];
+        m_wideNew[0] = clipSample(left >> PAN_SHIFT);
+        m_wideNew[1] = clipSample(right >> PAN_SHIFT);
+    }
+
+    if (m_nearest) {
+        buf[0] = m_wideNew[0];
+        buf[1] = m_wideNew[1];
+    } else {
+        int32_t ratio = m_chip.rateratio;
+        int32_t count = m_chip.samplecnt;
+        buf[0] = static_cast<short>((m_wideOld[0] * (ratio - count) + m_wideNew[0] * count) / ratio);
+        buf[1] = static_cast<short>((m_wideOld[1] * (ratio - count) + m_wideNew[1] * count) / ratio);
+    }
+    m_chip.samplecnt += 1 << NUKED_RSM_FRAC;
+}
+
+void CChanopl::generateStems(short* buf)
+{
+    while (m_chip.samplecnt >= m_chip.rateratio) {
+        m_chip.oldsamples[0] = m_chip.samples[0];
+        m_chip.oldsamples[1] = m_chip.samples[1];
+        OPL3_Generate(&m_chip, m_chip.samples);
+        m_chip.samplecnt -= m_chip.rateratio;
+
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            m_stemOld[ch] = m_stemNew[ch];
+            m_stemNew[ch] = clipSample(channelOutput(ch));
+        }
+    }
+
+    int32_t ratio = m_chip.rateratio;
+    int32_t count = m_chip.samplecnt;
+    buf[0] = static_cast<short>((m_chip.oldsamples[0] * (ratio - count) + m_chip.samples[0] * count) / ratio);
+    buf[1] = static_cast<short>((m_chip.oldsamples[1] * (ratio - count) + m_chip.samples[1] * count) / ratio);
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        m_stemOut[ch] = static_cast<short>((m_stemOld[ch] * (ratio - count) + m_stemNew[ch] * count) / ratio);
+    }
+    m_stemOut += CHANNELS;
+    m_chip.samplecnt += 1 << NUKED_RSM_FRAC;
+}
+
+void CChanopl::update(short* buf, int samples)
+{
+    generate(buf, samples);
+}
+
+void CChanopl::render(short* buf, int samples, const OplWrite* writes, int count)
+{
+    int pos = 0;
+    int next = 0;
+    for (;;) {
+        // Once the block is rendered, everything left is applied
+        while (next < count && (static_cast<int>(writes[next].offset) <= pos || pos >= samples)) {
+            const OplWrite& w = writes[next++];
+            if (w.chip == OPL_WRITE_INIT) {
+                CChanopl::init();
+            } else {
+                currChip = w.chip;
+                CChanopl::write(w.reg, w.val);
+            }
+        }
+        if (pos >= samples) {
+            break;
+        }
+
+        int end = samples;
+        if (next < count && static_cast<int>(writes[next].offset) < end) {
+            end = static_cast<int>(writes[next].offset);
+        }
+        generate(&buf[pos * 2], end - pos);
+        pos = end;
+    }
+}
+
+void CChanopl::generate(short* buf, int samples)
+{
+    // OPL3-mode songs pan themselves; stems are always the plain chip path
+    bool wide = m_wide && !m_chip.newm && !m_stemOut;
+
+    if (!m_stemOut && !m_scopeRing && !wide) {
+        if (m_nearest) {
+            for (int i = 0; i < samples; i++) {
+                generateNearest(&m_chip, &buf[i * 2]);
+            }
+            return;
+        }
+        // Same path as CNemuopl
+        OPL3_GenerateStream(&m_chip, buf, samples);
+        return;
+    }
+
+    for (int i = 0; i < samples; i++) {
+        if (m_stemOut) {
+            generateStems(&buf[i * 2]);
+        } else if (wide) {
+            generateWide(&buf[i * 2]);
+        } else if (m_nearest) {
+            generateNearest(&m_chip, &buf[i * 2]);
+        } else {
+            OPL3_GenerateResampled(&m_chip, &buf[i * 2]);
+        }
+
+        // Plain decimation: scopes show the waveform shape, aliasing is acceptable
+        if (m_scopeRing && ++m_scopePhase >= m_scopeDecimation) {
+            m_scopePhase = 0;
+            captureScopeFrame();
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * chanopl.h - Nuked OPL3 emulator with per-channel output taps
+ *
+ * Drop-in replacement for CNemuopl that can additionally report the
+ * output of each of the 18 OPL channels while the normal stereo mix is
+ * generated, so per-channel data costs no extra synthesis. Channel
+ * output goes either to a full-rate stem buffer (export) or to a
+ * decimated ring for oscilloscope display. The same taps drive an
+ * optional pseudo-stereo mix for OPL2 songs.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef H_CHANOPL
+#define H_CHANOPL
+
+#include <cstdint>
+
+#include "opl.h"
+#include "nukedopl.h"
+
+// Register write stamped with the output frame it precedes (see
+// CQualityopl::beginQueue)
+struct OplWrite {
+    uint32_t offset;    // Output frames into the block
+    uint8_t chip;       // Register set, or OPL_WRITE_INIT for a chip reset
+    uint8_t reg;
+    uint8_t val;
+};
+
+static const uint8_t OPL_WRITE_INIT = 0xFF;
+
+class CChanopl : public Copl
+{
+public:
+    static const int CHANNELS = 18;
+
+    CChanopl(int rate);
+    virtual ~CChanopl() {}
+
+    virtual void init() override;
+    virtual void write(int reg, int val) override;
+    virtual void update(short* buf, int samples) override;
+
+    /**
+     * Render a block in one run, applying queued writes at their frames
+     * Writes with offset >= samples are applied after the last frame
+     * @param writes Sorted by offset
+     */
+    void render(short* buf, int samples, const OplWrite* writes, int count);
+
+    /**
+     * Route per-channel output into a stem buffer during update()
+     * Each output frame appends CHANNELS interleaved int16 values,
+     * resampled the same way as the mix so the stems sum to it
+     * @param stemBuf Destination (advanced by update), or null to stop
+     */
+    void setStemOutput(short* stemBuf);
+
+    /**
+     * Take the latest chip sample instead of interpolating between the
+     * two around each output sample (cheaper, adds aliasing)
+     * Stem output always uses the interpolating path
+     * @param nearest true to bypass the interpolating resampler
+     */
+    void setNearestResampling(bool nearest) { m_nearest = nearest; }
+
+    /**
+     * Capture every decimation-th output frame of each channel into a ring
+     * Each captured frame is CHANNELS interleaved int16 values
+     * @param ring Ring buffer of frames * CHANNELS values, or null to stop
+     * @param frames Ring capacity in frames
+     * @param decimation Output samples per captured frame (>= 1)
+     */
+    void setScopeOutput(short* ring, int frames, int decimation);
+
+    // Frames captured since setScopeOutput (next write is at scopeWritten() % frames)
+    uint32_t scopeWritten() const { return m_scopeWritten; }
+
+    /**
+     * Spread the channels of OPL2-mode songs across the stereo field
+     * The mix is rebuilt from the channel taps with a fixed pan per
+     * channel, so it costs no second chip (unlike CSurroundopl).
+     * Songs that enable OPL3 mode keep their own panning.
+     * @param percent 0 = off (chip mix), 100 = widest
+     */
+    void setStereoWidth(int percent);
+
+    /**
+     * Current envelope level of a channel, for level meters
+     * Derived from the operator attenuation, so it costs no synthesis
+     * @param ch Channel 0..CHANNELS-1
+     * @return 0.0 (silent) ~ 1.0 (full level)
+     */
+    float channelLevel(int ch) const;
+
+private:
+    // Synthesize samples frames with the current register state
+    void generate(short* buf, int samples);
+
+    // Current output of one channel (sum of its operator outputs)
+    int channelOutput(int ch) const;
+
+    // Store the current channel outputs as one scope frame
+    void captureScopeFrame();
+
+    // OPL3_GenerateResampled with the panned channel mix
+    void generateWide(short* buf);
+
+    // OPL3_GenerateResampled that also interpolates each channel into m_stemOut
+    void generateStems(short* buf);
+
+    opl3_chip m_chip;
+    int m_rate;
+    short* m_stemOut;
+    int16_t m_stemOld[CHANNELS];  // Channel outputs at the previous / current chip sample
+    int16_t m_stemNew[CHANNELS];
+    bool m_nearest;
+
+    short* m_scopeRing;
+    int m_scopeFrames;
+    int m_scopeDecimation;
+    int m_scopePhase;         // Output samples since the last capture
+    uint32_t m_scopeWritten;
+
+    bool m_wide;
+    int m_panLeft[CHANNELS];    // Q12 gains
+    int m_panRight[CHANNELS];
+    int16_t m_wideOld[2];       // Panned mix at the previous / current chip sample
+    int16_t m_wideNew[2];
+};
+
+#endif
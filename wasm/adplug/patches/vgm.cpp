@@ -185,15 +185,30 @@ bool CvgmPlayer::load(const std::string &filename, const CFileProvider &fp)
 		f->seek(OFFSET_EOF);
 		gd3_ofs = f->readInt(4);
 	}
+	// GD3/EOF offsets come from the file; never trust them past its end
+	f->seek(0, binio::End);
+	long data_avail = f->pos() - (OFFSET_DATA + data_ofs);
 	f->seek(OFFSET_DATA + data_ofs);
 	data_sz = gd3_ofs - data_ofs;
-	vgmData = new uint8_t[data_sz];
+	if (data_sz <= 0 || data_sz > data_avail)
+		data_sz = data_avail;
+	if (data_sz <= 0)
+	{
+		// No command data
+		fp.close(f);
+		return false;
+	}
+	// 2 zero bytes of padding so a truncated last command reads no further
+	vgmData = new uint8_t[data_sz + 2];
 	for (int i = 0; i < data_sz; i++)
 	{
 		vgmData[i] = f->readInt(1);
 	}
+	vgmData[data_sz] = vgmData[data_sz + 1] = 0;
 	fp.close(f);
 	loop_ofs -= data_ofs + (OFFSET_DATA - OFFSET_LOOP);
+	if (loop_ofs >= data_sz)
+		loop_ofs = -1;  // 데이터 밖을 가리키는 루프는 무시
 	rewind(0);
 	return true;
 }
@@ -201,6 +216,7 @@ bool CvgmPlayer::load(const std::string &filename, const CFileProvider &fp)
 bool CvgmPlayer::update()
 {
 	uint8_t reg, val;
+	int loop_jumps = 0;  // 한 번의 update 안에서 루프 시작으로 돌아간 횟수
 	wait = 0;
 
 	do
@@ -209,6 +225,7 @@ bool CvgmPlayer::update()
 		{
 			if (loop_ofs >= 0 && g_loopEnabled) {
 				pos = loop_ofs;  // loop 위치로 이동, 계속 재생
+				loop_jumps++;
 			} else {
 				songend = true;  // loop 없거나 비활성화면 종료
 				break;
@@ -252,6 +269,7 @@ bool CvgmPlayer::update()
 		case CMD_DATA_END:
 			if (loop_ofs >= 0 && g_loopEnabled) {
 				pos = loop_ofs;  // loop 활성화면 loop 위치로
+				loop_jumps++;
 			} else {
 				pos = data_sz;   // loop 없거나 비활성화면 종료
 				songend = true;
@@ -270,6 +288,12 @@ bool CvgmPlayer::update()
 		if (pos >= data_sz && loop_ofs >= 0 && g_loopEnabled) {
 			pos = loop_ofs;
 			songend = false;  // 루프 시 songend 리셋
+			loop_jumps++;
+		}
+		if (!wait && loop_jumps > 1) {
+			// 루프 구간에 대기 명령이 없으면 update가 끝나지 않으므로 종료 처리
+			songend = true;
+			break;
 		}
 	} while (!wait);
 	return !songend;
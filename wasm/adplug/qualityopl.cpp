@@ -0,0 +1,277 @@
+/*
+ * qualityopl.cpp - OPL proxy that can swap emulator cores mid-song
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#include <cstring>
+
+#include "emuopl.h"
+#include "wemuopl.h"
+
+#include "qualityopl.h"
+
+// Key-on registers are replayed after everything else
+static inline bool isKeyRegister(int reg)
+{
+    return (reg >= 0xB0 && reg <= 0xB8) || reg == 0xBD;
+}
+
+// Timer registers act on every write (start, stop, IRQ reset)
+static inline bool isTimerRegister(int chip, int reg)
+{
+    return chip == 0 && reg >= 0x02 && reg <= 0x04;
+}
+
+// Registers that change how later writes are decoded: waveform select
+// enable, note select, 4-op connections and OPL3 mode (which masks the
+// E0 waveform and C0 output bits when they are written)
+static inline bool isModeRegister(int chip, int reg)
+{
+    return chip == 0 ? (reg == 0x01 || reg == 0x08) : (reg == 0x04 || reg == 0x05);
+}
+
+CQualityopl::CQualityopl(CChanopl* nuked, int rate)
+    : m_nuked(nuked), m_opl2(nullptr), m_fast(nullptr), m_active(nuked),
+      m_rate(rate), m_level(LEVEL_FULL), m_secondSetUsed(false),
+      m_writesApplied(0), m_writesDropped(0), m_queueing(false), m_flushing(false),
+      m_switchPending(false), m_queueOffset(0)
+{
+    currType = TYPE_OPL3;
+    clearShadow();
+}
+
+CQualityopl::~CQualityopl()
+{
+    delete m_opl2;
+    delete m_fast;
+}
+
+void CQualityopl::init()
+{
+    currChip = 0;
+    clearShadow();
+    if (m_queueing) {
+        OplWrite reset = { m_queueOffset, OPL_WRITE_INIT, 0, 0 };
+        m_queue.push_back(reset);
+        return;
+    }
+    resetCore();
+}
+
+void CQualityopl::write(int reg, int val)
+{
+    reg &= 0xFF;
+    val &= 0xFF;
+    if (m_shadow.isRedundant(currChip, reg, val)) {
+        m_writesDropped++;
+        return;
+    }
+    m_writesApplied++;
+
+    // The shadow follows the player, so while queueing it runs ahead of
+    // the audio by up to one block
+    shadowWrite(currChip, reg, val);
+
+    if (m_queueing) {
+        OplWrite write = { m_queueOffset, static_cast<uint8_t>(currChip),
+                           static_cast<uint8_t>(reg), static_cast<uint8_t>(val) };
+        m_queue.push_back(write);
+        return;
+    }
+    apply(currChip, reg, val);
+}
+
+void CQualityopl::apply(int chip, int reg, int val)
+{
+    if (chip == 1 && val != 0 && m_active == m_opl2) {
+        if (m_flushing) {
+            // The shadow is already at the end of the block, so replaying it
+            // now would play later writes early; the OPL2 core cannot play
+            // the second set anyway, so switch once the block is rendered
+            m_switchPending = true;
+            return;
+        }
+        // The replay includes this write
+        switchCore(coreForLevel(m_level));
+        return;
+    }
+
+    m_active->setchip(chip);
+    m_active->write(reg, val);
+}
+
+void CQualityopl::resetCore()
+{
+    // A new song may fit the OPL2 core again
+    m_switchPending = false;
+    m_active = coreForLevel(m_level);
+    m_active->init();
+}
+
+void CQualityopl::update(short* buf, int samples)
+{
+    m_active->update(buf, samples);
+}
+
+void CQualityopl::beginQueue()
+{
+    m_queueing = true;
+    m_queueOffset = 0;
+    m_queue.clear();
+}
+
+void CQualityopl::render(short* buf, int samples)
+{
+    m_queueing = false;
+
+    if (m_active == m_nuked) {
+        // Nuked stays active across the block: only apply() on the OPL2
+        // core and setLevel() switch cores
+        m_nuked->render(buf, samples, m_queue.data(), static_cast<int>(m_queue.size()));
+    } else {
+        m_flushing = true;
+        int pos = 0;
+        for (const OplWrite& w : m_queue) {
+            int offset = static_cast<int>(w.offset) < samples ? static_cast<int>(w.offset) : samples;
+            if (offset > pos) {
+                m_active->update(&buf[pos * 2], offset - pos);
+                pos = offset;
+            }
+            if (w.chip == OPL_WRITE_INIT) {
+                resetCore();
+            } else {
+                apply(w.chip, w.reg, w.val);
+            }
+        }
+        if (pos < samples) {
+            m_active->update(&buf[pos * 2], samples - pos);
+        }
+        m_flushing = false;
+    }
+
+    m_queue.clear();
+
+    // Block boundary: the shadow matches the audio again
+    if (m_switchPending) {
+        m_switchPending = false;
+        switchCore(coreForLevel(m_level));
+    }
+}
+
+void OplShadow::clear()
+{
+    memset(regs, 0, sizeof(regs));
+    memset(known, 1, sizeof(known));
+}
+
+bool OplShadow::isRedundant(int chip, int reg, int val) const
+{
+    // Rewriting B0-B8 / BD with key-on still set is not a retrigger (the
+    // chips only act on the key bit changing), so those are dropped too
+    return known[chip][reg] && regs[chip][reg] == val && !isTimerRegister(chip, reg);
+}
+
+void OplShadow::write(int chip, int reg, int val)
+{
+    bool modeChanged = isModeRegister(chip, reg) && regs[chip][reg] != val;
+
+    regs[chip][reg] = static_cast<uint8_t>(val);
+    if (modeChanged) {
+        // Registers written under the old mode may decode differently now,
+        // so the next write to each must reach the chip
+        memset(known, 0, sizeof(known));
+    }
+    known[chip][reg] = true;
+}
+
+void CQualityopl::shadowWrite(int chip, int reg, int val)
+{
+    m_shadow.write(chip, reg, val);
+    if (chip == 1 && val != 0) {
+        m_secondSetUsed = true;
+    }
+}
+
+void CQualityopl::clearShadow()
+{
+    m_shadow.clear();
+    m_secondSetUsed = false;
+}
+
+void CQualityopl::setLevel(int level)
+{
+    if (level < LEVEL_FULL) level = LEVEL_FULL;
+    if (level >= LEVELS) level = LEVELS - 1;
+    m_level = level;
+    m_nuked->setNearestResampling(level == LEVEL_NEAREST);
+    switchCore(coreForLevel(level));
+}
+
+Copl* CQualityopl::coreForLevel(int level)
+{
+    if (level == LEVEL_OPL2 && m_secondSetUsed) {
+        level = LEVEL_FAST_CORE;
+    }
+
+    switch (level) {
+    case LEVEL_OPL2:
+        if (!m_opl2) {
+            m_opl2 = new CEmuopl(m_rate, true, true);
+        }
+        return m_opl2;
+    case LEVEL_FAST_CORE:
+        if (!m_fast) {
+            m_fast = new CWemuopl(m_rate, true, true);
+        }
+        return m_fast;
+    default:
+        return m_nuked;
+    }
+}
+
+void CQualityopl::switchCore(Copl* core)
+{
+    if (core == m_active) {
+        return;
+    }
+    core->init();
+    replayRegisters(core);
+    m_active = core;
+}
+
+void CQualityopl::replayRegisters(Copl* core)
+{
+    writeRegisterFile(core, m_shadow.regs);
+    core->setchip(currChip);
+}
+
+void CQualityopl::writeRegisterFile(Copl* core, const uint8_t regs[2][256])
+{
+    // OPL3 enable and 4-op connection select decide how the rest is read
+    core->setchip(1);
+    core->write(0x05, regs[1][0x05]);
+    core->write(0x04, regs[1][0x04]);
+
+    for (int chip = 0; chip < 2; chip++) {
+        core->setchip(chip);
+        for (int reg = 0x01; reg <= 0xFF; reg++) {
+            // Timer registers are left alone, as are the two written above
+            bool timer = isTimerRegister(chip, reg);
+            bool mode = chip == 1 && (reg == 0x04 || reg == 0x05);
+            if (timer || mode || isKeyRegister(reg)) {
+                continue;
+            }
+            core->write(reg, regs[chip][reg]);
+        }
+    }
+
+    for (int chip = 0; chip < 2; chip++) {
+        core->setchip(chip);
+        for (int reg = 0xB0; reg <= 0xBD; reg++) {
+            if (isKeyRegister(reg)) {
+                core->write(reg, regs[chip][reg]);
+            }
+        }
+    }
+}
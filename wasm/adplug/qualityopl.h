@@ -0,0 +1,140 @@
+/*
+ * qualityopl.h - OPL proxy that can swap emulator cores mid-song
+ *
+ * Players write to this proxy; it forwards to the core selected by the
+ * quality level and keeps a shadow copy of both register sets. Switching
+ * cores initializes the new one and replays the shadow registers (key-on
+ * last), so a song keeps playing across the switch with only held notes
+ * restarting their envelopes.
+ *
+ * Writes can also be queued with their output frame offsets, letting a
+ * player run ahead over a whole block that is then rendered in one run.
+ *
+ * The shadow also filters writes that would not change a register, which
+ * players refreshing pitch or levels every tick produce in bulk.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef H_QUALITYOPL
+#define H_QUALITYOPL
+
+#include <cstdint>
+#include <vector>
+
+#include "opl.h"
+#include "chanopl.h"
+
+// Register file that knows which writes cannot change chip state
+struct OplShadow
+{
+    uint8_t regs[2][256];
+    bool known[2][256];     // Value matches what the chip holds
+
+    OplShadow() { clear(); }
+
+    // Every core resets all registers to zero
+    void clear();
+
+    // True if writing val would change nothing (timer registers never are)
+    bool isRedundant(int chip, int reg, int val) const;
+
+    void write(int chip, int reg, int val);
+};
+
+class CQualityopl : public Copl
+{
+public:
+    // Ordered from best to cheapest
+    enum Level {
+        LEVEL_FULL = 0,     // Nuked OPL3, interpolating resampler
+        LEVEL_NEAREST,      // Nuked OPL3, nearest-sample resampling
+        LEVEL_OPL2,         // MAME OPL2 at the output rate (first register set only)
+        LEVEL_FAST_CORE,    // DOSBox OPL3 at the output rate
+        LEVELS
+    };
+
+    /**
+     * @param nuked Full quality core (not owned; stem and level taps stay on it)
+     * @param rate Output sample rate
+     */
+    CQualityopl(CChanopl* nuked, int rate);
+    virtual ~CQualityopl();
+
+    virtual void init() override;
+    virtual void write(int reg, int val) override;
+    virtual void update(short* buf, int samples) override;
+
+    /**
+     * Select the quality level
+     * Songs using the second register set (OPL3 mode or dual OPL2) cannot
+     * run on the OPL2 core; LEVEL_OPL2 uses the fast OPL3 core for them
+     * @param level LEVEL_FULL..LEVELS-1
+     */
+    void setLevel(int level);
+    int level() const { return m_level; }
+
+    // True while the Nuked core (with channel level taps) is producing audio
+    bool usesNuked() const { return m_active == m_nuked; }
+
+    /**
+     * Queue writes and resets instead of applying them, until render()
+     * Each is stamped with the frame offset reached by advanceQueue()
+     */
+    void beginQueue();
+
+    // Move the stamp for later writes forward by samples frames
+    void advanceQueue(int samples) { m_queueOffset += static_cast<uint32_t>(samples); }
+
+    /**
+     * Render the queued block and apply the queue at its offsets, ending queueing
+     * The Nuked core renders the block in one run; the cheaper cores are
+     * updated between writes. A second-set write on the OPL2 core switches
+     * cores after the block, once the shadow matches the audio again
+     */
+    void render(short* buf, int samples);
+
+    /**
+     * Write a whole register file to a freshly initialized core
+     * Mode registers go first and key-on registers last; timers are skipped
+     * @param regs Register sets 0 and 1
+     */
+    static void writeRegisterFile(Copl* core, const uint8_t regs[2][256]);
+
+    // Writes passed on / dropped as redundant since the last resetWriteStats()
+    uint32_t writesApplied() const { return m_writesApplied; }
+    uint32_t writesDropped() const { return m_writesDropped; }
+    void resetWriteStats() { m_writesApplied = m_writesDropped = 0; }
+
+private:
+    // Record a write in the shadow registers
+    void shadowWrite(int chip, int reg, int val);
+    void clearShadow();
+
+    // Pass a write to the active core (switching off the OPL2 core if needed)
+    void apply(int chip, int reg, int val);
+    void resetCore();
+
+    Copl* coreForLevel(int level);
+    void switchCore(Copl* core);
+    void replayRegisters(Copl* core);
+
+    CChanopl* m_nuked;
+    Copl* m_opl2;      // Created on first use
+    Copl* m_fast;
+    Copl* m_active;
+    int m_rate;
+    int m_level;
+    bool m_secondSetUsed;   // Song has written to register set 1
+    OplShadow m_shadow;
+    uint32_t m_writesApplied;
+    uint32_t m_writesDropped;
+
+    bool m_queueing;
+    bool m_flushing;        // render() is applying the queue
+    bool m_switchPending;   // Leave the OPL2 core once the block is rendered
+    uint32_t m_queueOffset;
+    std::vector<OplWrite> m_queue;
+};
+
+#endif
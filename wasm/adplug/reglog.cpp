@@ -0,0 +1,339 @@
+/*
+ * reglog.cpp - Sample-timed register log for capture formats
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "adplug.h"
+#include "dro.h"
+#include "dro2.h"
+#include "imf.h"
+#include "mus.h"
+#include "raw.h"
+#include "rol.h"
+
+#include "reglog.h"
+
+// Same tick timing as the adapter's tick loop (16-bit fraction)
+static const int FIXED_POINT_SHIFT = 16;
+static const uint64_t FIXED_POINT_ONE = 1ULL << FIXED_POINT_SHIFT;
+
+static const size_t SNAPSHOT_INTERVAL = 4096;
+static const size_t SNAPSHOT_SIZE = 2 * 256;
+
+// A song ends once its log holds this many writes, to bound the memory
+static const size_t MAX_WRITES = 1 << 22;
+
+// Records writes with the output frame of the tick that made them,
+// leaving out those that would not change chip state
+class CRecordopl : public Copl
+{
+public:
+    CRecordopl(std::vector<OplWrite>& writes) : frame(0), m_writes(writes)
+    {
+        currType = TYPE_OPL3;
+    }
+
+    virtual void init() override
+    {
+        currChip = 0;
+        m_shadow.clear();
+        OplWrite reset = { frame, OPL_WRITE_INIT, 0, 0 };
+        m_writes.push_back(reset);
+    }
+
+    virtual void write(int reg, int val) override
+    {
+        reg &= 0xFF;
+        val &= 0xFF;
+        if (m_shadow.isRedundant(currChip, reg, val)) {
+            return;
+        }
+        m_shadow.write(currChip, reg, val);
+
+        OplWrite write = { frame, static_cast<uint8_t>(currChip),
+                           static_cast<uint8_t>(reg), static_cast<uint8_t>(val) };
+        m_writes.push_back(write);
+    }
+
+    virtual void update(short*, int) override {}
+
+    uint32_t frame;     // Stamp for the writes that follow
+
+private:
+    std::vector<OplWrite>& m_writes;
+    OplShadow m_shadow;
+};
+
+static inline void applyWrite(Copl* opl, const OplWrite& w)
+{
+    if (w.chip == OPL_WRITE_INIT) {
+        opl->init();
+    } else {
+        opl->setchip(w.chip);
+        opl->write(w.reg, w.val);
+    }
+}
+
+CRegLog::CRegLog()
+    : m_active(false), m_tickCount(0), m_sampleRate(0), m_frame(0), m_next(0),
+      m_recorder(nullptr), m_player(nullptr), m_recordFrame(0), m_recordFixed(0),
+      m_maxFrames(0), m_endFrame(0), m_snapshotted(0)
+{
+    memset(m_regs, 0, sizeof(m_regs));
+}
+
+CRegLog::~CRegLog()
+{
+    clear();
+}
+
+bool CRegLog::handles(CPlayer* player)
+{
+    return dynamic_cast<CdroPlayer*>(player) || dynamic_cast<Cdro2Player*>(player) ||
+           dynamic_cast<CimfPlayer*>(player) || dynamic_cast<CrawPlayer*>(player) ||
+           dynamic_cast<CrolPlayer*>(player) || dynamic_cast<CmusPlayer*>(player);
+}
+
+void CRegLog::clear()
+{
+    delete m_player;
+    m_player = nullptr;
+    delete m_recorder;
+    m_recorder = nullptr;
+
+    std::vector<OplWrite>().swap(m_writes);
+    std::vector<uint8_t>().swap(m_snapshots);
+    std::vector<TickSegment>().swap(m_ticks);
+    m_tickCount = 0;
+    m_active = false;
+    m_frame = 0;
+    m_next = 0;
+    m_recordFrame = 0;
+    m_recordFixed = 0;
+    m_endFrame = 0;
+    memset(m_regs, 0, sizeof(m_regs));
+    m_snapshotted = 0;
+}
+
+bool CRegLog::begin(const std::string& filename, const CFileProvider& fp,
+                    int subsong, int sampleRate, uint64_t maxFrames)
+{
+    clear();
+
+    m_recorder = new CRecordopl(m_writes);
+    m_player = CAdPlug::factory(filename, m_recorder, CAdPlug::players, fp);
+    if (!m_player) {
+        clear();
+        return false;
+    }
+
+    // Only what the rewind writes counts; loading may have written too.
+    // Playback starts from a freshly initialized chip, as does the shadow
+    m_recorder->init();
+    m_writes.clear();
+    m_player->rewind(subsong);
+
+    m_sampleRate = sampleRate;
+    m_maxFrames = maxFrames < UINT32_MAX ? maxFrames : UINT32_MAX;
+    m_active = true;
+    return true;
+}
+
+void CRegLog::record(uint64_t frame)
+{
+    while (m_player && m_recordFrame <= frame) {
+        recordTick();
+    }
+
+    // Register file before every SNAPSHOT_INTERVAL-th write
+    for (; m_snapshotted < m_writes.size(); m_snapshotted++) {
+        if (m_snapshotted % SNAPSHOT_INTERVAL == 0) {
+            const uint8_t* bytes = &m_regs[0][0];
+            m_snapshots.insert(m_snapshots.end(), bytes, bytes + SNAPSHOT_SIZE);
+        }
+        const OplWrite& w = m_writes[m_snapshotted];
+        if (w.chip == OPL_WRITE_INIT) {
+            memset(m_regs, 0, sizeof(m_regs));
+        } else {
+            m_regs[w.chip][w.reg] = w.val;
+        }
+    }
+}
+
+void CRegLog::recordTick()
+{
+    m_recorder->frame = static_cast<uint32_t>(m_recordFrame);
+    uint64_t startFixed = (m_recordFrame << FIXED_POINT_SHIFT) | m_recordFixed;
+    bool playing = m_player->update();
+    m_tickCount++;
+    if (!playing) {
+        finish();
+        return;
+    }
+
+    double refreshRate = m_player->getrefresh();
+    if (!(refreshRate > 0)) refreshRate = 70.0;
+    if (refreshRate > m_sampleRate) refreshRate = m_sampleRate;
+    uint64_t samplesPerTickFixed = static_cast<uint64_t>(
+        static_cast<double>(m_sampleRate) / refreshRate * FIXED_POINT_ONE);
+
+    if (m_ticks.empty() || m_ticks.back().samplesPerTickFixed != samplesPerTickFixed) {
+        TickSegment segment = { m_tickCount - 1, startFixed, samplesPerTickFixed };
+        m_ticks.push_back(segment);
+    }
+
+    m_recordFixed += samplesPerTickFixed;
+    m_recordFrame += m_recordFixed >> FIXED_POINT_SHIFT;
+    m_recordFixed &= FIXED_POINT_ONE - 1;
+    if (m_recordFrame > m_maxFrames || m_writes.size() > MAX_WRITES) {
+        finish();
+    }
+}
+
+void CRegLog::finish()
+{
+    delete m_player;
+    m_player = nullptr;
+    delete m_recorder;
+    m_recorder = nullptr;
+    m_endFrame = m_recordFrame;
+}
+
+const CRegLog::TickSegment* CRegLog::segmentAt(uint64_t frame) const
+{
+    if (m_ticks.empty()) {
+        return nullptr;
+    }
+    uint64_t posFixed = frame << FIXED_POINT_SHIFT;
+    auto after = std::upper_bound(m_ticks.begin(), m_ticks.end(), posFixed,
+        [](uint64_t pos, const TickSegment& s) { return pos < s.startFixed; });
+    return after == m_ticks.begin() ? &m_ticks.front() : &*(after - 1);
+}
+
+unsigned long CRegLog::tickAt(uint64_t frame) const
+{
+    if (frame == 0) {
+        return 0;
+    }
+    const TickSegment* segment = segmentAt(frame);
+    if (!segment || (!m_player && frame >= m_endFrame)) {
+        return m_tickCount;
+    }
+
+    // Tick k of the segment starts on frame (startFixed + k * length) >> 16;
+    // count those starting before frame
+    uint64_t posFixed = frame << FIXED_POINT_SHIFT;
+    if (posFixed <= segment->startFixed) {
+        return segment->firstTick;
+    }
+    uint64_t span = posFixed - segment->startFixed;
+    uint64_t ticks = (span + segment->samplesPerTickFixed - 1) / segment->samplesPerTickFixed;
+    unsigned long tick = segment->firstTick + static_cast<unsigned long>(ticks);
+    return tick < m_tickCount ? tick : m_tickCount;
+}
+
+float CRegLog::refreshAt(uint64_t frame) const
+{
+    const TickSegment* segment = segmentAt(frame);
+    if (!segment) {
+        return 70.0f;
+    }
+    return static_cast<float>(static_cast<double>(m_sampleRate) * FIXED_POINT_ONE /
+                              segment->samplesPerTickFixed);
+}
+
+int CRegLog::queue(CQualityopl* opl, int frames)
+{
+    uint64_t end = m_frame + static_cast<uint64_t>(frames);
+    record(end);
+    if (!m_player && end > m_endFrame) {
+        end = m_endFrame;
+    }
+    // The last tick's writes sit on the end frame itself
+    bool atEnd = !m_player && end == m_endFrame;
+
+    uint64_t cursor = m_frame;
+    while (m_next < m_writes.size()) {
+        const OplWrite& w = m_writes[m_next];
+        if (w.offset > end || (w.offset == end && !atEnd)) {
+            break;
+        }
+        opl->advanceQueue(static_cast<int>(w.offset - cursor));
+        cursor = w.offset;
+        applyWrite(opl, w);
+        m_next++;
+    }
+    opl->advanceQueue(static_cast<int>(end - cursor));
+
+    int covered = static_cast<int>(end - m_frame);
+    m_frame = end;
+    return covered;
+}
+
+void CRegLog::skip(CQualityopl* opl, uint64_t frames)
+{
+    uint64_t end = m_frame + frames;
+    record(end);
+    if (!m_player && end > m_endFrame) {
+        end = m_endFrame;
+    }
+    while (m_next < m_writes.size() && m_writes[m_next].offset < end) {
+        applyWrite(opl, m_writes[m_next++]);
+    }
+    m_frame = end;
+}
+
+void CRegLog::seek(Copl* opl, uint64_t frame)
+{
+    record(frame);
+    if (!m_player && frame > m_endFrame) {
+        frame = m_endFrame;
+    }
+
+    // Writes on the target frame itself are queued by the next render
+    auto first = std::lower_bound(m_writes.begin(), m_writes.end(), frame,
+        [](const OplWrite& w, uint64_t f) { return w.offset < f; });
+    size_t count = static_cast<size_t>(first - m_writes.begin());
+
+    uint8_t regs[2][256];
+    stateAt(count, regs);
+    opl->init();
+    CQualityopl::writeRegisterFile(opl, regs);
+    opl->setchip(0);
+
+    m_frame = frame;
+    m_next = count;
+}
+
+void CRegLog::rewind(Copl* opl)
+{
+    opl->init();
+    m_frame = 0;
+    m_next = 0;
+}
+
+void CRegLog::stateAt(size_t count, uint8_t regs[2][256]) const
+{
+    // The snapshot of a multiple of SNAPSHOT_INTERVAL is only taken once
+    // the write after it is recorded
+    if (count == m_snapshotted) {
+        memcpy(regs, m_regs, SNAPSHOT_SIZE);
+        return;
+    }
+
+    size_t snapshot = count / SNAPSHOT_INTERVAL;
+    memcpy(regs, &m_snapshots[snapshot * SNAPSHOT_SIZE], SNAPSHOT_SIZE);
+
+    for (size_t i = snapshot * SNAPSHOT_INTERVAL; i < count; i++) {
+        const OplWrite& w = m_writes[i];
+        if (w.chip == OPL_WRITE_INIT) {
+            memset(regs, 0, SNAPSHOT_SIZE);
+        } else {
+            regs[w.chip][w.reg] = w.val;
+        }
+    }
+}
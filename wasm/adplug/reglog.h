@@ -0,0 +1,146 @@
+/*
+ * reglog.h - Sample-timed register log for capture formats
+ *
+ * DRO, IMF and RAW files are plain register dumps with delays, yet their
+ * players run through the generic tick loop: one update() per delay step,
+ * a refresh query and a fixed-point conversion each time. Instead, the
+ * song is decoded into a single array of writes stamped with output
+ * frames, and one interpreter feeds it to the OPL proxy's write queue, so
+ * delays are exact and a block renders in one run.
+ *
+ * ROL and MUS/IMS use the same log. Their loaders are left as they are (a
+ * merged event array would need new members in rol.h / mus.h, which
+ * patches/ does not carry); the log stands in for it: ROL's per-voice
+ * note, instrument, volume and pitch lists and the tempo list, or the
+ * MUS running-status stream, come out as one time-sorted array of
+ * register writes with instruments already resolved. Writes that would
+ * not change a register (ROL refreshes pitch every tick) are dropped
+ * while recording. The player still runs the first time through a
+ * stretch; replays (loop, rewind, seeking back) only touch the writes
+ * that fire.
+ *
+ * Tick timing is kept as segments of constant tick length, so tempo
+ * changes become absolute frame positions; the tick count (ISS lyrics)
+ * and refresh rate at any frame are a binary search away.
+ *
+ * The log is recorded lazily: the load only starts a second player on a
+ * recording chip, and rendering or seeking records ticks as far as it
+ * needs, so the decode is spread over playback instead of added to the
+ * load. Once a stretch is recorded, replaying it (loop, rewind, seeking
+ * back) costs no player ticks.
+ *
+ * The register file is snapshotted every few thousand writes; seeking is
+ * a binary search, a short replay from the nearest snapshot and one
+ * register-file write to the chip.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef H_REGLOG
+#define H_REGLOG
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "player.h"
+#include "qualityopl.h"
+
+class CRecordopl;
+
+class CRegLog
+{
+public:
+    CRegLog();
+    ~CRegLog();
+
+    // True for players whose output is fully determined at load (dumps, ROL, MUS/IMS)
+    static bool handles(CPlayer* player);
+
+    /**
+     * Start decoding a song by loading it into a second player that writes
+     * to a recording chip; ticks are recorded on demand. Tick lengths follow
+     * the player's refresh rate exactly as the tick loop would, so playback
+     * is sample-identical
+     * @param sampleRate Output sample rate the frames are counted in
+     * @param maxFrames The song ends here if it has not ended before, as
+     *                  it does once the log holds too many writes
+     * @return false if the song cannot be loaded; the log is then empty
+     */
+    bool begin(const std::string& filename, const CFileProvider& fp,
+               int subsong, int sampleRate, uint64_t maxFrames);
+
+    void clear();
+    bool active() const { return m_active; }
+
+    // Current position in output frames
+    uint64_t position() const { return m_frame; }
+
+    // Player ticks started before a frame, as the tick loop counts them
+    unsigned long tickAt(uint64_t frame) const;
+
+    // Player refresh rate (ticks per second) in effect at a frame
+    float refreshAt(uint64_t frame) const;
+
+    /**
+     * Queue the writes of the next frames on the proxy (between beginQueue and render)
+     * Writes on the final frame are included once the end is reached
+     * @return Frames covered, less than frames only at the end of the song
+     */
+    int queue(CQualityopl* opl, int frames);
+
+    /**
+     * Move forward without synthesis; writes on the way are queued at the
+     * current queue offset so chip state stays consistent
+     */
+    void skip(CQualityopl* opl, uint64_t frames);
+
+    // Restore the chip state at a frame (clamped to the end of the song);
+    // frames not recorded yet are recorded first
+    void seek(Copl* opl, uint64_t frame);
+
+    // Back to the start with a freshly initialized chip
+    void rewind(Copl* opl);
+
+private:
+    // Run of ticks of equal length
+    struct TickSegment {
+        unsigned long firstTick;
+        uint64_t startFixed;            // Start frame of firstTick, 16-bit fraction
+        uint64_t samplesPerTickFixed;
+    };
+
+    // Record ticks until every write up to frame is in the log
+    void record(uint64_t frame);
+    void recordTick();
+
+    // Song over (or capped): the recording player is released
+    void finish();
+
+    // Register state after the first count writes
+    void stateAt(size_t count, uint8_t regs[2][256]) const;
+
+    // Segment containing a frame (the first one for frames before it)
+    const TickSegment* segmentAt(uint64_t frame) const;
+
+    bool m_active;
+    std::vector<OplWrite> m_writes;     // offset = output frame from the song start
+    std::vector<uint8_t> m_snapshots;   // Register file before every SNAPSHOT_INTERVAL-th write
+    std::vector<TickSegment> m_ticks;
+    unsigned long m_tickCount;          // Ticks recorded so far
+    int m_sampleRate;
+    uint64_t m_frame;                   // Next frame to render
+    size_t m_next;                      // First write not yet queued
+
+    // Recording state
+    CRecordopl* m_recorder;
+    CPlayer* m_player;                  // nullptr once the song has ended
+    uint64_t m_recordFrame;             // Frame the next recorded tick starts on
+    uint64_t m_recordFixed;             // Its 16-bit fraction
+    uint64_t m_maxFrames;
+    uint64_t m_endFrame;                // Valid once m_player is released
+    uint8_t m_regs[2][256];             // Register file after the snapshotted writes
+    size_t m_snapshotted;               // Writes covered by m_regs
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * pattern_state.h - Pattern position changes within a render block
+ *
+ * Engines only tell where they are (order, pattern, row, speed) at the
+ * moment a render call returns, so a pattern view polling that lags or
+ * skips rows. Instead the adapters record every change while rendering,
+ * stamped with its frame offset into the block, and the UI reads the
+ * list after each render call. Only changes are recorded: most blocks
+ * have none or one.
+ *
+ * All fields are 32-bit for Int32Array views from JS; keep the layout in
+ * sync with app/lib/pattern-state.ts.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef IMSPLAY_PATTERN_STATE_H
+#define IMSPLAY_PATTERN_STATE_H
+
+#include <cstdint>
+
+// A 512-1024 frame block spans a few rows at most; more only at absurd speeds
+static const int PATTERN_STATE_MAX_CHANGES = 64;
+
+struct PatternChange {
+    uint32_t frame;     // Offset into the block the position holds from
+    int32_t order;
+    int32_t pattern;
+    int32_t row;
+    int32_t speed;      // Ticks per row
+};
+
+struct PatternState {
+    uint32_t count;     // Changes recorded during the last render call
+    uint32_t dropped;   // Changes past capacity (the last slot holds the latest)
+    PatternChange changes[PATTERN_STATE_MAX_CHANGES];
+};
+
+// Recording side of a PatternState: each adapter owns one
+struct PatternRecorder {
+    PatternState state; // Read by the UI
+    PatternChange last; // Last recorded position
+    bool known;         // last is valid
+};
+
+// Start a render call's list
+static inline void patternStateBegin(PatternRecorder& rec)
+{
+    rec.state.count = 0;
+    rec.state.dropped = 0;
+}
+
+// Forget the last position (load, seek) so the next record is always kept
+static inline void patternStateInvalidate(PatternRecorder& rec)
+{
+    rec.known = false;
+}
+
+/**
+ * Record the position at a frame of the current block if it changed
+ * @param frame Frame offset into the block
+ */
+static inline void patternStateRecord(PatternRecorder& rec, uint32_t frame, int32_t order,
+                                      int32_t pattern, int32_t row, int32_t speed)
+{
+    PatternChange& last = rec.last;
+    if (rec.known && last.order == order && last.pattern == pattern &&
+        last.row == row && last.speed == speed) {
+        return;
+    }
+    rec.known = true;
+    last.frame = frame;
+    last.order = order;
+    last.pattern = pattern;
+    last.row = row;
+    last.speed = speed;
+
+    PatternState& state = rec.state;
+    if (state.count < PATTERN_STATE_MAX_CHANGES) {
+        state.changes[state.count++] = last;
+    } else {
+        state.changes[PATTERN_STATE_MAX_CHANGES - 1] = last;
+        state.dropped++;
+    }
+}
+
+#endif // IMSPLAY_PATTERN_STATE_H
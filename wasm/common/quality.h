@@ -0,0 +1,95 @@
+/*
+ * quality.h - Adaptive render quality driven by render cost
+ *
+ * Each render call reports its cost as a fraction of the audio it
+ * produced (the same ratio render_stats.h records). The load is smoothed
+ * and quality steps down one level once it stays above the step-down
+ * threshold for a few calls. Stepping back up needs a much lower load
+ * held for a few seconds, so the level does not flap around one
+ * threshold. What each level costs and sounds like is up to the adapter;
+ * level 0 is always full quality.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef IMSPLAY_QUALITY_H
+#define IMSPLAY_QUALITY_H
+
+// Smoothed load (render time / audio time) thresholds
+static const double QUALITY_STEP_DOWN_LOAD = 0.7;
+static const double QUALITY_STEP_UP_LOAD = 0.3;
+// Weight of the newest call in the smoothed load
+static const double QUALITY_LOAD_SMOOTHING = 0.125;
+// Consecutive calls beyond a threshold before the level changes
+// (a call is ~10-20 ms of audio, so stepping up waits several seconds)
+static const int QUALITY_STEP_DOWN_CALLS = 8;
+static const int QUALITY_STEP_UP_CALLS = 400;
+
+struct QualityController {
+    bool enabled;
+    int level;          // 0 = full quality
+    int maxLevel;       // Cheapest level the adapter offers
+    double load;        // Smoothed render/audio time ratio
+    int pressureCalls;  // Consecutive calls above QUALITY_STEP_DOWN_LOAD
+    int headroomCalls;  // Consecutive calls below QUALITY_STEP_UP_LOAD
+};
+
+/**
+ * Force a level and restart the hysteresis counters
+ * The smoothed load is reseeded between the thresholds, since the history
+ * was measured at the old level
+ * @param level Clamped to 0..maxLevel
+ */
+static inline void qualitySetLevel(QualityController& q, int level)
+{
+    if (level < 0) level = 0;
+    if (level > q.maxLevel) level = q.maxLevel;
+    q.level = level;
+    q.load = (QUALITY_STEP_DOWN_LOAD + QUALITY_STEP_UP_LOAD) / 2;
+    q.pressureCalls = 0;
+    q.headroomCalls = 0;
+}
+
+/**
+ * Turn adaptation on or off; turning it off restores full quality
+ * @param enabled Adapt the level to render cost
+ * @param maxLevel Cheapest level the adapter offers
+ */
+static inline void qualityConfigure(QualityController& q, bool enabled, int maxLevel)
+{
+    q.enabled = enabled;
+    q.maxLevel = maxLevel > 0 ? maxLevel : 0;
+    qualitySetLevel(q, enabled ? q.level : 0);
+}
+
+/**
+ * Feed one render call to the controller
+ * @param renderUs Wall-clock time spent in the call (microseconds)
+ * @param frames Frames produced by the call (calls producing none are ignored)
+ * @param sampleRate Output sample rate
+ * @return true if the level changed and the adapter must apply it
+ */
+static inline bool qualityRecord(QualityController& q, double renderUs, int frames, int sampleRate)
+{
+    if (!q.enabled || frames <= 0 || sampleRate <= 0) {
+        return false;
+    }
+
+    double ratio = renderUs * sampleRate / (static_cast<double>(frames) * 1e6);
+    q.load += (ratio - q.load) * QUALITY_LOAD_SMOOTHING;
+
+    q.pressureCalls = q.load > QUALITY_STEP_DOWN_LOAD ? q.pressureCalls + 1 : 0;
+    q.headroomCalls = q.load < QUALITY_STEP_UP_LOAD ? q.headroomCalls + 1 : 0;
+
+    if (q.pressureCalls >= QUALITY_STEP_DOWN_CALLS && q.level < q.maxLevel) {
+        qualitySetLevel(q, q.level + 1);
+        return true;
+    }
+    if (q.headroomCalls >= QUALITY_STEP_UP_CALLS && q.level > 0) {
+        qualitySetLevel(q, q.level - 1);
+        return true;
+    }
+    return false;
+}
+
+#endif // IMSPLAY_QUALITY_H
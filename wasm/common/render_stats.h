@@ -0,0 +1,81 @@
+/*
+ * render_stats.h - Render deadline telemetry shared by the adapters
+ *
+ * Every render call is measured against the duration of the audio it
+ * produced. The ratio (render time / audio time) goes into a log-bucket
+ * histogram, and calls using more than 50%, 80% and 100% of their budget
+ * are counted. 100% means the call took longer than real time, i.e. an
+ * underrun unless enough audio was buffered ahead. Adapters driving a
+ * register-level emulator also report how many writes were filtered out.
+ *
+ * The RenderStats struct is read directly from WASM memory by the TS
+ * wrappers; keep its layout in sync with app/lib/render-stats.ts.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef IMSPLAY_RENDER_STATS_H
+#define IMSPLAY_RENDER_STATS_H
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Histogram covers ratios 2^-10 (0.1%) .. 2^6 (6400%) in quarter octaves;
+// values outside the range land in the first/last bucket
+static const int RENDER_STATS_BUCKETS_PER_OCTAVE = 4;
+static const int RENDER_STATS_MIN_LOG2 = -10;
+static const int RENDER_STATS_BUCKETS = 16 * RENDER_STATS_BUCKETS_PER_OCTAVE;
+
+struct RenderStats {
+    uint32_t calls;
+    uint32_t over50;          // Calls above 50% of the audio duration
+    uint32_t over80;
+    uint32_t over100;         // Calls slower than real time
+    uint32_t worstPermille;   // Highest ratio seen, in 1/1000
+    uint32_t buckets[RENDER_STATS_BUCKETS];
+    uint32_t regWrites;       // Register writes passed to the emulator
+    uint32_t regWritesDropped; // Writes dropped as redundant (0 where not applicable)
+};
+
+static inline void renderStatsReset(RenderStats& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * Record one render call
+ * @param renderUs Wall-clock time spent in the call (microseconds)
+ * @param frames Frames produced by the call (calls producing none are ignored)
+ * @param sampleRate Output sample rate
+ */
+static inline void renderStatsRecord(RenderStats& stats, double renderUs, int frames, int sampleRate)
+{
+    if (frames <= 0 || sampleRate <= 0) {
+        return;
+    }
+
+    double audioUs = static_cast<double>(frames) * 1e6 / sampleRate;
+    double ratio = renderUs / audioUs;
+
+    stats.calls++;
+    if (ratio > 0.5) stats.over50++;
+    if (ratio > 0.8) stats.over80++;
+    if (ratio > 1.0) stats.over100++;
+
+    double permille = ratio * 1000.0;
+    if (permille > stats.worstPermille) {
+        stats.worstPermille = permille < 4e9 ? static_cast<uint32_t>(permille) : 0xFFFFFFFFu;
+    }
+
+    int bucket = 0;
+    if (ratio > 0) {
+        bucket = static_cast<int>(std::floor(
+            (std::log2(ratio) - RENDER_STATS_MIN_LOG2) * RENDER_STATS_BUCKETS_PER_OCTAVE));
+    }
+    if (bucket < 0) bucket = 0;
+    if (bucket >= RENDER_STATS_BUCKETS) bucket = RENDER_STATS_BUCKETS - 1;
+    stats.buckets[bucket]++;
+}
+
+#endif // IMSPLAY_RENDER_STATS_H
@@ -0,0 +1,54 @@
+/*
+ * state_block.h - Playback state published for JS readers
+ *
+ * The renderer writes one PublishedState per render call; readers copy
+ * it out of the WASM heap without calling into the engine.
+ *
+ * The WASM builds are single-threaded (no -pthread, so the heap is a plain
+ * ArrayBuffer, not a SharedArrayBuffer): the block is only read on the
+ * thread that owns the module, between render calls, so a reader never
+ * sees a half-written block and no locking is needed. The adapters fill a
+ * local PublishedState and copy it into the block in one assignment.
+ *
+ * All fields are 32-bit so the block can be read from JS through
+ * Int32Array/Float32Array views. Keep the layout in sync with
+ * app/lib/playback-state.ts.
+ *
+ * Each adapter owns its block; the functions below take it explicitly.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef IMSPLAY_STATE_BLOCK_H
+#define IMSPLAY_STATE_BLOCK_H
+
+#include <cstdint>
+
+// Channel levels carried in the block (OPL3 has 18, trackers up to 64 shown)
+static const int STATE_MAX_CHANNELS = 64;
+
+struct PublishedState {
+    uint32_t version;       // Incremented on every publish
+    uint32_t positionMs;
+    uint32_t tick;          // Player ticks since start (0 if the engine has none)
+    int32_t order;          // -1 if the format has no order list
+    int32_t pattern;
+    int32_t row;
+    uint32_t loopCount;     // Times playback wrapped to the start
+    uint32_t channelCount;  // Valid entries in levels
+    float levels[STATE_MAX_CHANNELS];  // 0.0 ~ 1.0 per channel
+};
+
+/**
+ * Replace the published block with a new state
+ * @param block Block read by JS
+ * @param state New contents (its version is ignored)
+ */
+static inline void statePublish(PublishedState& block, const PublishedState& state)
+{
+    uint32_t version = block.version + 1;
+    block = state;
+    block.version = version;
+}
+
+#endif // IMSPLAY_STATE_BLOCK_H
@@ -0,0 +1,157 @@
+/*
+ * trace.h - Render timeline tracing shared by the adapters
+ *
+ * Records named spans into a preallocated ring and exports them as Chrome
+ * trace-event JSON (open in Perfetto or chrome://tracing). Recording is
+ * off by default; a disabled TraceSpan costs one branch.
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef IMSPLAY_TRACE_H
+#define IMSPLAY_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <chrono>
+#endif
+
+// Ring capacity is capped so a bad argument cannot exhaust WASM memory
+static const int TRACE_MAX_EVENTS = 1 << 20;
+
+struct TraceEvent {
+    const char* name;   // String literal, never freed
+    double startUs;
+    float durationUs;
+    int32_t arg;        // Span-specific value (tick, sample count, ms...)
+};
+
+// Each adapter owns one ring, so their timelines export separately
+struct TraceRing {
+    std::vector<TraceEvent> events;
+    size_t next = 0;       // Next slot to write
+    size_t count = 0;      // Valid events (<= ring size)
+    bool enabled = false;
+};
+
+// Monotonic time in microseconds
+static inline double traceNowUs()
+{
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now() * 1000.0;
+#else
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Start recording into a fresh ring, or stop and free it
+ * @param capacity Number of events kept (oldest are overwritten), 0 = disable
+ */
+static inline void traceEnable(TraceRing& ring, int capacity)
+{
+    if (capacity > TRACE_MAX_EVENTS) capacity = TRACE_MAX_EVENTS;
+    std::vector<TraceEvent>().swap(ring.events);
+    ring.next = 0;
+    ring.count = 0;
+    ring.enabled = capacity > 0;
+    if (ring.enabled) {
+        ring.events.resize(static_cast<size_t>(capacity));
+    }
+}
+
+// Drop recorded events but keep recording
+static inline void traceClear(TraceRing& ring)
+{
+    ring.next = 0;
+    ring.count = 0;
+}
+
+static inline void traceRecord(TraceRing& ring, const char* name, double startUs, double endUs,
+                               int32_t arg)
+{
+    if (!ring.enabled) {
+        return;
+    }
+    TraceEvent& event = ring.events[ring.next];
+    event.name = name;
+    event.startUs = startUs;
+    event.durationUs = static_cast<float>(endUs - startUs);
+    event.arg = arg;
+    ring.next = (ring.next + 1) % ring.events.size();
+    if (ring.count < ring.events.size()) {
+        ring.count++;
+    }
+}
+
+/**
+ * Scoped span: records [construction, destruction) when tracing is on
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(TraceRing& ring, const char* name, int32_t arg = 0)
+        : m_ring(ring), m_name(name), m_arg(arg), m_active(ring.enabled),
+          m_startUs(m_active ? traceNowUs() : 0) {}
+
+    ~TraceSpan()
+    {
+        if (m_active) {
+            traceRecord(m_ring, m_name, m_startUs, traceNowUs(), m_arg);
+        }
+    }
+
+    // Set the recorded value once it is known (e.g. frames actually read)
+    void setArg(int32_t arg) { m_arg = arg; }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    TraceRing& m_ring;
+    const char* m_name;
+    int32_t m_arg;
+    bool m_active;
+    double m_startUs;
+};
+
+/**
+ * Serialize the ring, oldest first, as Chrome trace-event JSON
+ * @param ring Ring to serialize
+ * @param out Receives the JSON document
+ * @param processName Shown as the process label in the viewer
+ */
+static inline void traceExportJson(const TraceRing& ring, std::string& out, const char* processName)
+{
+    char line[256];
+    out.clear();
+    out.reserve(ring.count * 96 + 256);
+
+    snprintf(line, sizeof(line),
+             "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+             "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"%s\"}}",
+             processName);
+    out += line;
+
+    size_t size = ring.events.size();
+    size_t first = size ? (ring.next + size - ring.count) % size : 0;
+    for (size_t i = 0; i < ring.count; i++) {
+        const TraceEvent& event = ring.events[(first + i) % size];
+        snprintf(line, sizeof(line),
+                 ",\n{\"name\":\"%s\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                 "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"value\":%d}}",
+                 event.name, event.startUs, static_cast<double>(event.durationUs), event.arg);
+        out += line;
+    }
+
+    out += "\n]}\n";
+}
+
+#endif // IMSPLAY_TRACE_H
@@ -0,0 +1,90 @@
+/*
+ * wav.h - RIFF/WAVE header writer shared by the WASM adapters
+ *
+ * Copyright (C) 2025, MIT License
+ */
+
+#ifndef IMSPLAY_WAV_H
+#define IMSPLAY_WAV_H
+
+#include <cstdint>
+#include <cstring>
+
+// Size of the canonical PCM WAV header (mono / stereo)
+static const int WAV_HEADER_SIZE = 44;
+// Size of the WAVE_FORMAT_EXTENSIBLE header used for more than two channels
+static const int WAV_EXTENSIBLE_HEADER_SIZE = 68;
+
+static const uint16_t WAV_FORMAT_PCM = 0x0001;
+static const uint16_t WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// KSDATAFORMAT_SUBTYPE_PCM {00000001-0000-0010-8000-00AA00389B71}
+static const uint8_t WAV_SUBTYPE_PCM[16] = {
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+// Store little-endian integers regardless of host byte order
+static inline void wavPut16(uint8_t* dst, uint16_t v)
+{
+    dst[0] = static_cast<uint8_t>(v);
+    dst[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static inline void wavPut32(uint8_t* dst, uint32_t v)
+{
+    dst[0] = static_cast<uint8_t>(v);
+    dst[1] = static_cast<uint8_t>(v >> 8);
+    dst[2] = static_cast<uint8_t>(v >> 16);
+    dst[3] = static_cast<uint8_t>(v >> 24);
+}
+
+/**
+ * Header size writeWavHeader() produces for a channel count
+ */
+static inline int wavHeaderSize(int channels)
+{
+    return channels > 2 ? WAV_EXTENSIBLE_HEADER_SIZE : WAV_HEADER_SIZE;
+}
+
+/**
+ * Write a PCM WAV header of wavHeaderSize(channels) bytes
+ * Mono and stereo get the canonical 44-byte header; more channels need
+ * WAVE_FORMAT_EXTENSIBLE. Its channel mask is 0 (no speaker positions),
+ * since multichannel exports are per-instrument stems, not surround layouts
+ * @param dst Destination (at least wavHeaderSize(channels) bytes)
+ * @param sampleRate Sample rate in Hz
+ * @param channels Number of interleaved channels
+ * @param bitsPerSample Bits per sample (16 for int16 PCM)
+ * @param dataBytes Size of the sample data following the header
+ */
+static inline void writeWavHeader(uint8_t* dst, int sampleRate, int channels,
+                                  int bitsPerSample, uint32_t dataBytes)
+{
+    uint16_t blockAlign = static_cast<uint16_t>(channels * bitsPerSample / 8);
+    bool extensible = channels > 2;
+    uint32_t fmtSize = extensible ? 40 : 16;
+    uint8_t* data = dst + 20 + fmtSize;
+
+    memcpy(dst, "RIFF", 4);
+    wavPut32(dst + 4, static_cast<uint32_t>(wavHeaderSize(channels) - 8) + dataBytes);
+    memcpy(dst + 8, "WAVE", 4);
+    memcpy(dst + 12, "fmt ", 4);
+    wavPut32(dst + 16, fmtSize);
+    wavPut16(dst + 20, extensible ? WAV_FORMAT_EXTENSIBLE : WAV_FORMAT_PCM);
+    wavPut16(dst + 22, static_cast<uint16_t>(channels));
+    wavPut32(dst + 24, static_cast<uint32_t>(sampleRate));
+    wavPut32(dst + 28, static_cast<uint32_t>(sampleRate) * blockAlign);
+    wavPut16(dst + 32, blockAlign);
+    wavPut16(dst + 34, static_cast<uint16_t>(bitsPerSample));
+    if (extensible) {
+        wavPut16(dst + 36, 22);             // Extension size
+        wavPut16(dst + 38, static_cast<uint16_t>(bitsPerSample)); // Valid bits
+        wavPut32(dst + 40, 0);              // Channel mask
+        memcpy(dst + 44, WAV_SUBTYPE_PCM, sizeof(WAV_SUBTYPE_PCM));
+    }
+    memcpy(data, "data", 4);
+    wavPut32(data + 4, dataBytes);
+}
+
+#endif // IMSPLAY_WAV_H
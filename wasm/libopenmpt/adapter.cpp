@@ -9,18 +9,98 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <cmath>
+
+#include <string>
+#include <vector>
 
 #include "libopenmpt.h"
+#include "libopenmpt_ext.h"
+
+#include "wav.h"
+#include "trace.h"
+#include "render_stats.h"
+#include "state_block.h"
+#include "pattern_state.h"
+#include "quality.h"
+
+// Exceptions never cross into JavaScript: libopenmpt's C API catches its
+// own, and the adapter catches around the entry points that allocate with
+// standard containers (export, trace), so the build can use native WASM
+// exception handling (-fwasm-exceptions) instead of the JS emulation
 
 // Audio buffer size (frames per call, stereo)
 static const int AUDIO_BUFFER_FRAMES = 1024;
 
+// Overview (seek-bar waveform) analysis settings
+// Rendered mono at a low rate with nearest-neighbour interpolation
+static const int OVERVIEW_SAMPLE_RATE = 8000;
+static const double OVERVIEW_MAX_DURATION_SECONDS = 30.0 * 60.0;
+static const int OVERVIEW_MAX_BUCKETS = 65536;
+
+// Interpolation filter taps per quality level (0 = libopenmpt default,
+// 8-tap windowed sinc); the last level is linear interpolation
+static const int QUALITY_FILTER_LENGTHS[] = { 0, 2 };
+static const int QUALITY_LEVELS = sizeof(QUALITY_FILTER_LENGTHS) / sizeof(QUALITY_FILTER_LENGTHS[0]);
+
+// With pattern tracking on, changes are sampled between reads of this many
+// frames (row positions are accurate to about 3 ms at 44.1 kHz)
+static const int PATTERN_STATE_STEP_FRAMES = 128;
+
+// Offline export: modules longer than this are cut
+static const double EXPORT_MAX_DURATION_SECONDS = 30.0 * 60.0;
+// Upper bound on tracker channels rendered as separate stems
+static const int EXPORT_MAX_STEMS = 64;
+// Exports are rendered at the playback level (libopenmpt.ts sets the same gain)
+static const int32_t EXPORT_MASTER_GAIN_MILLIBEL = 100;
+// Render parameters a stem instance copies from the mixed module
+static const int STEM_RENDER_PARAMS[] = {
+    OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL,
+    OPENMPT_MODULE_RENDER_STEREOSEPARATION_PERCENT,
+    OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH,
+    OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH,
+};
+
 // Global state
 static openmpt_module* g_module = nullptr;
 static int g_sampleRate = 48000;
 static float* g_audioBuffer = nullptr;  // Interleaved stereo float buffer
 static int g_audioBufferFrames = 0;
 static int g_repeatCount = 0;  // 0 = no repeat, -1 = infinite
+static uint8_t* g_fileData = nullptr;   // Copy of loaded file (for re-opening in analysis)
+static size_t g_fileSize = 0;
+static float* g_overviewBuffer = nullptr; // min/max/rms triplets per bucket
+static int g_overviewBuckets = 0;
+
+// Offline export (WAV header + interleaved 16-bit stereo PCM)
+static std::vector<uint8_t> g_exportBuffer;
+static size_t g_exportFrames = 0;
+static size_t g_exportExpectedFrames = 0;
+static size_t g_exportMaxFrames = 0;
+static bool g_exportActive = false;
+static int g_exportChannels = 2;                          // 2 = stereo mix, otherwise one per stem
+static std::vector<openmpt_module_ext*> g_exportStemModules; // Solo instance per stem, null if silent
+static std::vector<int16_t> g_exportStemScratch;
+static int32_t g_exportSavedGain = 0;                      // Master gain of g_module before the export
+static bool g_exportGainSet = false;
+
+// State behind the helpers in ../common (each adapter has its own)
+static TraceRing g_trace;
+static RenderStats g_renderStats;
+static PublishedState g_publishedState;
+static PatternRecorder g_pattern;
+static QualityController g_quality = { false, 0, 0, 0.0, 0, 0 };
+
+// Last trace export (kept alive for the caller to read)
+static std::string g_traceJson;
+
+// Published state: wraps are detected as the position going backwards
+static const openmpt_module* g_stateModule = nullptr;  // Module the counters belong to
+static double g_statePositionSeconds = 0.0;
+static bool g_stateSeeked = false;        // Next backward jump is a seek, not a loop
+static uint32_t g_loopCount = 0;
+static const openmpt_module* g_patternModule = nullptr; // Module g_pattern.last belongs to
+static bool g_patternTracking = false;    // Split reads for frame-accurate changes
 
 // Track info strings
 static char g_title[256] = {0};
@@ -28,6 +108,327 @@ static char g_artist[256] = {0};
 static char g_type[256] = {0};
 static char g_trackInfo[1024] = {0};
 
+// Release the overview analysis result
+static void freeOverview()
+{
+    if (g_overviewBuffer) {
+        free(g_overviewBuffer);
+        g_overviewBuffer = nullptr;
+    }
+    g_overviewBuckets = 0;
+}
+
+// Release the stored copy of the loaded file
+static void freeFileData()
+{
+    if (g_fileData) {
+        free(g_fileData);
+        g_fileData = nullptr;
+    }
+    g_fileSize = 0;
+}
+
+// Destroy the per-stem module instances of a stem export
+static void freeStemModules()
+{
+    for (openmpt_module_ext* ext : g_exportStemModules) {
+        if (ext) {
+            openmpt_module_ext_destroy(ext);
+        }
+    }
+    g_exportStemModules.clear();
+    std::vector<int16_t>().swap(g_exportStemScratch);
+}
+
+// Find the channels that play at least one note anywhere in the module
+static std::vector<bool> findSoundingChannels(openmpt_module* mod, int channels)
+{
+    std::vector<bool> sounding(channels, false);
+    int remaining = channels;
+    int32_t patterns = openmpt_module_get_num_patterns(mod);
+    for (int32_t pattern = 0; pattern < patterns && remaining > 0; pattern++) {
+        int32_t rows = openmpt_module_get_pattern_num_rows(mod, pattern);
+        for (int32_t row = 0; row < rows && remaining > 0; row++) {
+            for (int ch = 0; ch < channels; ch++) {
+                if (sounding[ch]) {
+                    continue;
+                }
+                // 1-120 are notes; 0 is empty, 253+ are note off/cut/fade
+                uint8_t note = openmpt_module_get_pattern_row_channel_command(
+                    mod, pattern, row, ch, OPENMPT_MODULE_COMMAND_NOTE);
+                if (note >= 1 && note <= 120) {
+                    sounding[ch] = true;
+                    remaining--;
+                }
+            }
+        }
+    }
+    return sounding;
+}
+
+// Create one module instance per sounding tracker channel with all other
+// channels muted; channels without a single note get no instance and are
+// written as silence. libopenmpt only renders a mix (muting a channel still
+// runs the whole player), so there is no single-pass stem render: a stem
+// export costs one full render and one copy of the module per sounding
+// channel. The instances advance in lockstep so progress and the song end
+// are shared, and take g_module's render parameters so the stems add up to
+// the mix
+static bool createStemModules(int channels)
+{
+    freeStemModules();
+    std::vector<bool> sounding = findSoundingChannels(g_module, channels);
+    for (int ch = 0; ch < channels; ch++) {
+        if (!sounding[ch]) {
+            g_exportStemModules.push_back(nullptr);
+            continue;
+        }
+        openmpt_module_ext* ext = openmpt_module_ext_create_from_memory(
+            g_fileData, g_fileSize,
+            nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+        if (!ext) {
+            freeStemModules();
+            return false;
+        }
+        g_exportStemModules.push_back(ext);
+
+        openmpt_module_ext_interface_interactive interactive;
+        if (!openmpt_module_ext_get_interface(ext, LIBOPENMPT_EXT_C_INTERFACE_INTERACTIVE,
+                                              &interactive, sizeof(interactive))) {
+            freeStemModules();
+            return false;
+        }
+        for (int other = 0; other < channels; other++) {
+            interactive.set_channel_mute_status(ext, other, other != ch ? 1 : 0);
+        }
+
+        openmpt_module* mod = openmpt_module_ext_get_module(ext);
+        openmpt_module_set_repeat_count(mod, 0);
+        for (int param : STEM_RENDER_PARAMS) {
+            int32_t value;
+            if (openmpt_module_get_render_param(g_module, param, &value)) {
+                openmpt_module_set_render_param(mod, param, value);
+            }
+        }
+    }
+    return true;
+}
+
+// Put back the master gain g_module had before the export
+static void restoreExportGain()
+{
+    if (g_exportGainSet && g_module) {
+        openmpt_module_set_render_param(g_module, OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL,
+                                        g_exportSavedGain);
+    }
+    g_exportGainSet = false;
+}
+
+// Publish position, pattern position and channel VU for JS readers
+static void publishModuleState(openmpt_module* mod)
+{
+    if (mod != g_stateModule) {
+        // New module: start counting from scratch
+        g_stateModule = mod;
+        g_statePositionSeconds = 0.0;
+        g_loopCount = 0;
+    }
+
+    double position = openmpt_module_get_position_seconds(mod);
+    if (position < g_statePositionSeconds && !g_stateSeeked) {
+        g_loopCount++;
+    }
+    g_statePositionSeconds = position;
+    g_stateSeeked = false;
+
+    PublishedState state = {};
+    state.positionMs = static_cast<uint32_t>(position * 1000.0);
+    state.tick = 0;  // libopenmpt does not expose a tick counter
+    state.order = openmpt_module_get_current_order(mod);
+    state.pattern = openmpt_module_get_current_pattern(mod);
+    state.row = openmpt_module_get_current_row(mod);
+    state.loopCount = g_loopCount;
+
+    int channels = openmpt_module_get_num_channels(mod);
+    if (channels < 0) channels = 0;
+    if (channels > STATE_MAX_CHANNELS) channels = STATE_MAX_CHANNELS;
+    state.channelCount = static_cast<uint32_t>(channels);
+    for (int ch = 0; ch < channels; ch++) {
+        state.levels[ch] = openmpt_module_get_current_channel_vu_mono(mod, ch);
+    }
+    statePublish(g_publishedState, state);
+}
+
+// Record the module's pattern position at a frame of the block being read
+static void recordModulePattern(openmpt_module* mod, size_t frame)
+{
+    patternStateRecord(g_pattern, static_cast<uint32_t>(frame),
+                       openmpt_module_get_current_order(mod),
+                       openmpt_module_get_current_pattern(mod),
+                       openmpt_module_get_current_row(mod),
+                       openmpt_module_get_current_speed(mod));
+}
+
+// Read a block, recording the pattern position at its start
+// With pattern tracking on, the block is read in PATTERN_STATE_STEP_FRAMES
+// steps and changes between them are recorded too; otherwise it is one read
+// Returns frames read (fewer than frames only at the end of the song)
+static size_t readBlock(openmpt_module* mod, int sampleRate, size_t frames, float* out)
+{
+    if (mod != g_patternModule) {
+        g_patternModule = mod;
+        patternStateInvalidate(g_pattern);
+    }
+    patternStateBegin(g_pattern);
+    recordModulePattern(mod, 0);
+
+    if (!g_patternTracking) {
+        return openmpt_module_read_interleaved_float_stereo(mod, sampleRate, frames, out);
+    }
+
+    size_t done = 0;
+    while (done < frames) {
+        size_t step = frames - done;
+        if (step > PATTERN_STATE_STEP_FRAMES) step = PATTERN_STATE_STEP_FRAMES;
+        size_t got = openmpt_module_read_interleaved_float_stereo(
+            mod, sampleRate, step, out + done * 2);
+        done += got;
+        if (got < step) {
+            break;
+        }
+        // A change in the last step shows up at frame 0 of the next block
+        if (done < frames) {
+            recordModulePattern(mod, done);
+        }
+    }
+    return done;
+}
+
+// Apply the current quality level's interpolation filter to a module
+static void applyQuality(openmpt_module* mod)
+{
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH,
+                                    QUALITY_FILTER_LENGTHS[g_quality.level]);
+}
+
+// Drop an export that failed part way
+static void abortExport()
+{
+    g_exportActive = false;
+    freeStemModules();
+    restoreExportGain();
+    std::vector<uint8_t>().swap(g_exportBuffer);
+    g_exportFrames = 0;
+}
+
+// mpt_export_begin without the exception boundary
+static int exportBegin(int stems)
+{
+    if (!g_module) {
+        return -1;
+    }
+
+    g_exportChannels = 2;
+    freeStemModules();
+    restoreExportGain();
+
+    int32_t gain = 0;
+    openmpt_module_get_render_param(g_module, OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL, &gain);
+    g_exportSavedGain = gain;
+    g_exportGainSet = true;
+    openmpt_module_set_render_param(g_module, OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL,
+                                    EXPORT_MASTER_GAIN_MILLIBEL);
+
+    if (stems) {
+        int channels = openmpt_module_get_num_channels(g_module);
+        if (channels <= 0 || channels > EXPORT_MAX_STEMS || !g_fileData ||
+            !createStemModules(channels)) {
+            restoreExportGain();
+            return -1;
+        }
+        g_exportChannels = channels;
+    }
+
+    openmpt_module_set_repeat_count(g_module, 0);
+    openmpt_module_set_position_seconds(g_module, 0.0);
+
+    double duration = openmpt_module_get_duration_seconds(g_module);
+    g_exportExpectedFrames = duration > 0.0 ? (size_t)(duration * g_sampleRate) : 0;
+    g_exportMaxFrames = (size_t)(EXPORT_MAX_DURATION_SECONDS * g_sampleRate);
+    g_exportFrames = 0;
+
+    size_t headerSize = wavHeaderSize(g_exportChannels);
+    g_exportBuffer.assign(headerSize, 0);
+    g_exportBuffer.reserve(headerSize + g_exportExpectedFrames * g_exportChannels * sizeof(int16_t));
+    g_exportActive = true;
+    return 0;
+}
+
+// mpt_export_render without the exception boundary
+static int exportRender(int maxFrames)
+{
+    if (!g_exportActive || !g_module || maxFrames <= 0) {
+        return -1;
+    }
+
+    TraceSpan span(g_trace, "export", maxFrames);
+
+    size_t count = (size_t)maxFrames;
+    if (count > g_exportMaxFrames - g_exportFrames) {
+        count = g_exportMaxFrames - g_exportFrames;
+    }
+
+    size_t frameBytes = (size_t)g_exportChannels * sizeof(int16_t);
+    size_t offset = g_exportBuffer.size();
+    g_exportBuffer.resize(offset + count * frameBytes);
+    int16_t* dest = (int16_t*)&g_exportBuffer[offset];
+
+    size_t framesRead;
+    if (g_exportStemModules.empty()) {
+        framesRead = openmpt_module_read_interleaved_stereo(g_module, g_sampleRate, count, dest);
+    } else {
+        // Render each solo instance and interleave into the stem channels
+        memset(dest, 0, count * frameBytes);
+        framesRead = count;
+        bool anySounding = false;
+        g_exportStemScratch.resize(count);
+        for (size_t ch = 0; ch < g_exportStemModules.size(); ch++) {
+            if (!g_exportStemModules[ch]) {
+                continue;
+            }
+            anySounding = true;
+            openmpt_module* mod = openmpt_module_ext_get_module(g_exportStemModules[ch]);
+            size_t read = openmpt_module_read_mono(mod, g_sampleRate, count, g_exportStemScratch.data());
+            if (read < framesRead) {
+                framesRead = read;
+            }
+            for (size_t i = 0; i < read; i++) {
+                dest[i * g_exportChannels + ch] = g_exportStemScratch[i];
+            }
+        }
+        // Nothing ever plays a note: write the song's length of silence
+        if (!anySounding && framesRead > g_exportExpectedFrames - g_exportFrames) {
+            framesRead = g_exportExpectedFrames - g_exportFrames;
+        }
+    }
+    g_exportBuffer.resize(offset + framesRead * frameBytes);
+    g_exportFrames += framesRead;
+
+    if (framesRead < count || g_exportFrames >= g_exportMaxFrames) {
+        uint32_t dataBytes = (uint32_t)(g_exportBuffer.size() - wavHeaderSize(g_exportChannels));
+        writeWavHeader(g_exportBuffer.data(), g_sampleRate, g_exportChannels, 16, dataBytes);
+        freeStemModules();
+        g_exportActive = false;
+        return 1000;
+    }
+
+    if (g_exportExpectedFrames == 0) {
+        return 0;
+    }
+    size_t progress = g_exportFrames * 1000 / g_exportExpectedFrames;
+    return progress > 999 ? 999 : (int)progress;
+}
+
 extern "C" {
 
 /**
@@ -46,6 +447,8 @@ int mpt_init(int sampleRate)
         free(g_audioBuffer);
         g_audioBuffer = nullptr;
     }
+    freeOverview();
+    freeFileData();
 
     g_sampleRate = sampleRate > 0 ? sampleRate : 48000;
 
@@ -79,6 +482,12 @@ void mpt_teardown()
         free(g_audioBuffer);
         g_audioBuffer = nullptr;
     }
+    freeOverview();
+    freeFileData();
+    std::vector<uint8_t>().swap(g_exportBuffer);
+    g_exportActive = false;
+    g_exportGainSet = false;
+    freeStemModules();
     g_audioBufferFrames = 0;
 }
 
@@ -95,11 +504,16 @@ int mpt_load_file(const char* filename, const uint8_t* data, int size)
         return -1;
     }
 
+    TraceSpan span(g_trace, "load", size);
+
     // Clean up existing module
     if (g_module) {
         openmpt_module_destroy(g_module);
         g_module = nullptr;
     }
+    g_stateModule = nullptr;  // A new module may reuse the same address
+    freeOverview();
+    freeFileData();
 
     // Create module from memory
     g_module = openmpt_module_create_from_memory2(
@@ -118,8 +532,16 @@ int mpt_load_file(const char* filename, const uint8_t* data, int size)
         return -1;
     }
 
+    // Keep a copy for analysis passes that need their own module instance
+    g_fileData = (uint8_t*)malloc((size_t)size);
+    if (g_fileData) {
+        memcpy(g_fileData, data, (size_t)size);
+        g_fileSize = (size_t)size;
+    }
+
     // Set repeat count
     openmpt_module_set_repeat_count(g_module, g_repeatCount);
+    applyQuality(g_module);
 
     // Get track info
     const char* title = openmpt_module_get_metadata(g_module, "title");
@@ -165,15 +587,20 @@ int mpt_compute_audio_samples()
         return 1;
     }
 
+    TraceSpan span(g_trace, "render", AUDIO_BUFFER_FRAMES);
+    double startUs = traceNowUs();
+
     // Read interleaved stereo float samples
-    size_t framesRead = openmpt_module_read_interleaved_float_stereo(
-        g_module,
-        g_sampleRate,
-        AUDIO_BUFFER_FRAMES,
-        g_audioBuffer
-    );
+    size_t framesRead = readBlock(g_module, g_sampleRate, AUDIO_BUFFER_FRAMES, g_audioBuffer);
 
     g_audioBufferFrames = (int)framesRead;
+    span.setArg(g_audioBufferFrames);
+    double renderUs = traceNowUs() - startUs;
+    renderStatsRecord(g_renderStats, renderUs, g_audioBufferFrames, g_sampleRate);
+    if (qualityRecord(g_quality, renderUs, g_audioBufferFrames, g_sampleRate)) {
+        applyQuality(g_module);
+    }
+    publishModuleState(g_module);
 
     // Check if song ended
     if (framesRead == 0) {
@@ -224,8 +651,13 @@ double mpt_get_duration_seconds()
  */
 void mpt_set_position_seconds(double seconds)
 {
+    TraceSpan span(g_trace, "seek", static_cast<int32_t>(seconds * 1000.0));
+
     if (g_module) {
         openmpt_module_set_position_seconds(g_module, seconds);
+        g_stateSeeked = true;
+        patternStateInvalidate(g_pattern);
+        publishModuleState(g_module);
     }
 }
 
@@ -259,6 +691,8 @@ void mpt_rewind()
 {
     if (g_module) {
         openmpt_module_set_position_seconds(g_module, 0.0);
+        patternStateInvalidate(g_pattern);
+        publishModuleState(g_module);
     }
 }
 
@@ -270,4 +704,381 @@ int mpt_get_sample_rate()
     return g_sampleRate;
 }
 
+/**
+ * Start an offline export of the loaded module to WAV
+ * Rewinds the module and disables repeat until mpt_export_end()
+ * Intended for a dedicated module instance (e.g. in a Web Worker)
+ * @param stems 0 = stereo mix, 1 = one mono WAV channel per tracker channel
+ *              (renders the song once per channel that plays a note)
+ * @return 0 on success, -1 on failure
+ */
+int mpt_export_begin(int stems)
+{
+    try {
+        return exportBegin(stems);
+    } catch (...) {
+        // Out of memory for the WAV buffer or the stem instances
+        abortExport();
+        return -1;
+    }
+}
+
+/**
+ * Render the next part of the export in one large call
+ * @param maxFrames Maximum frames to render in this call
+ * @return Progress 0-999 while rendering, 1000 when the WAV is complete, -1 on error
+ */
+int mpt_export_render(int maxFrames)
+{
+    try {
+        return exportRender(maxFrames);
+    } catch (...) {
+        abortExport();
+        return -1;
+    }
+}
+
+/**
+ * Get pointer to the exported WAV file
+ */
+uint8_t* mpt_export_get_buffer()
+{
+    return g_exportBuffer.empty() ? nullptr : g_exportBuffer.data();
+}
+
+/**
+ * Get size of the exported WAV file in bytes
+ */
+int mpt_export_get_length()
+{
+    return (int)g_exportBuffer.size();
+}
+
+/**
+ * Release export memory and restore normal playback settings
+ */
+void mpt_export_end()
+{
+    g_exportActive = false;
+    freeStemModules();
+    restoreExportGain();
+    std::vector<uint8_t>().swap(g_exportBuffer);
+    g_exportFrames = 0;
+
+    if (g_module) {
+        openmpt_module_set_repeat_count(g_module, g_repeatCount);
+        openmpt_module_set_position_seconds(g_module, 0.0);
+    }
+}
+
+/**
+ * Render a min/max/RMS envelope of the whole song (seek-bar waveform)
+ * Opens a second module instance on the loaded file and renders it mono at a
+ * low sample rate without interpolation, so the playback state is untouched
+ * @param buckets Number of envelope buckets across the song duration
+ * @return 0 on success, -1 on failure
+ */
+int mpt_render_overview(int buckets)
+{
+    if (!g_fileData || buckets <= 0 || buckets > OVERVIEW_MAX_BUCKETS) {
+        return -1;
+    }
+
+    TraceSpan span(g_trace, "overview", buckets);
+
+    openmpt_module* mod = openmpt_module_create_from_memory2(
+        g_fileData, g_fileSize,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+    if (!mod) {
+        return -1;
+    }
+
+    openmpt_module_set_repeat_count(mod, 0);
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, 1);
+
+    double duration = openmpt_module_get_duration_seconds(mod);
+    if (duration <= 0.0) {
+        openmpt_module_destroy(mod);
+        return -1;
+    }
+    if (duration > OVERVIEW_MAX_DURATION_SECONDS) {
+        duration = OVERVIEW_MAX_DURATION_SECONDS;
+    }
+
+    freeOverview();
+    g_overviewBuffer = (float*)malloc((size_t)buckets * 3 * sizeof(float));
+    if (!g_overviewBuffer) {
+        openmpt_module_destroy(mod);
+        return -1;
+    }
+    g_overviewBuckets = buckets;
+
+    size_t totalFrames = (size_t)(duration * OVERVIEW_SAMPLE_RATE);
+    size_t framesPerBucket = (totalFrames + buckets - 1) / buckets;
+    if (framesPerBucket == 0) framesPerBucket = 1;
+
+    float buf[AUDIO_BUFFER_FRAMES];
+    size_t rendered = 0;
+    int bucket = 0;
+    float bucketMin = 0.0f, bucketMax = 0.0f;
+    double bucketSumSq = 0.0;
+    size_t bucketCount = 0;
+
+    auto flushBucket = [&]() {
+        if (bucket >= buckets) return;
+        float* out = &g_overviewBuffer[bucket * 3];
+        out[0] = bucketMin;
+        out[1] = bucketMax;
+        out[2] = bucketCount > 0 ? (float)sqrt(bucketSumSq / bucketCount) : 0.0f;
+        bucket++;
+        bucketMin = bucketMax = 0.0f;
+        bucketSumSq = 0.0;
+        bucketCount = 0;
+    };
+
+    while (rendered < totalFrames) {
+        size_t framesRead = openmpt_module_read_float_mono(
+            mod, OVERVIEW_SAMPLE_RATE, AUDIO_BUFFER_FRAMES, buf);
+        if (framesRead == 0) {
+            break;
+        }
+        for (size_t i = 0; i < framesRead && rendered < totalFrames; i++, rendered++) {
+            float v = buf[i];
+            if (v < bucketMin) bucketMin = v;
+            if (v > bucketMax) bucketMax = v;
+            bucketSumSq += (double)v * v;
+            bucketCount++;
+            if (bucketCount >= framesPerBucket) {
+                flushBucket();
+            }
+        }
+    }
+
+    // Flush the partial bucket and zero any buckets past the end of the song
+    if (bucketCount > 0) {
+        flushBucket();
+    }
+    while (bucket < buckets) {
+        flushBucket();
+    }
+
+    openmpt_module_destroy(mod);
+    return 0;
+}
+
+/**
+ * Get pointer to the overview result
+ * @return Pointer to buckets * 3 floats (min, max, rms per bucket), or null
+ */
+float* mpt_get_overview_buffer()
+{
+    return g_overviewBuffer;
+}
+
+/**
+ * Get number of buckets in the overview result
+ */
+int mpt_get_overview_buckets()
+{
+    return g_overviewBuckets;
+}
+
+/**
+ * Get the published playback state block
+ * Updated once per render call; see state_block.h for the layout
+ * @return Pointer to the state block
+ */
+PublishedState* mpt_get_state_block()
+{
+    return &g_publishedState;
+}
+
+/**
+ * Publish the state of a module rendered outside the adapter
+ * libopenmpt.ts playback owns its module and calls this after each read
+ * @param mod Module handle from openmpt_module_create_from_memory2
+ * @param seeked Non-zero if the position was changed since the last call
+ *               (a backward jump is then not counted as a loop)
+ */
+void mpt_publish_state(openmpt_module* mod, int seeked)
+{
+    if (!mod) {
+        return;
+    }
+    if (seeked) {
+        g_stateSeeked = true;
+        patternStateInvalidate(g_pattern);
+    }
+    publishModuleState(mod);
+}
+
+/**
+ * Read a block from a module rendered outside the adapter, recording
+ * pattern position changes on the way (see mpt_get_pattern_state)
+ * Same result as openmpt_module_read_interleaved_float_stereo
+ * @param mod Module handle from openmpt_module_create_from_memory2
+ * @param sampleRate Output sample rate
+ * @param frames Frames to read
+ * @param out Interleaved stereo float buffer of frames * 2 values
+ * @return Frames read, 0 at the end of the song
+ */
+int mpt_read_block(openmpt_module* mod, int sampleRate, int frames, float* out)
+{
+    if (!mod || !out || frames <= 0) {
+        return 0;
+    }
+
+    TraceSpan span(g_trace, "render", frames);
+    int framesRead = static_cast<int>(readBlock(mod, sampleRate, static_cast<size_t>(frames), out));
+    span.setArg(framesRead);
+    return framesRead;
+}
+
+/**
+ * Seek a module rendered outside the adapter, recording a trace span
+ * Same result as openmpt_module_set_position_seconds
+ * @param mod Module handle from openmpt_module_create_from_memory2
+ * @param seconds Target position
+ * @return Position actually reached in seconds
+ */
+double mpt_seek(openmpt_module* mod, double seconds)
+{
+    if (!mod) {
+        return 0.0;
+    }
+
+    TraceSpan span(g_trace, "seek", static_cast<int32_t>(seconds * 1000.0));
+    return openmpt_module_set_position_seconds(mod, seconds);
+}
+
+/**
+ * Record pattern position changes within blocks, not only at block starts
+ * Splits each read into PATTERN_STATE_STEP_FRAMES-frame calls, so enable
+ * it only while a pattern view is consuming the changes
+ * @param enabled 1 for frame-accurate changes, 0 for one read per block
+ */
+void mpt_set_pattern_tracking(int enabled)
+{
+    g_patternTracking = enabled != 0;
+}
+
+/**
+ * Get the pattern position changes of the last block read
+ * Layout: count, dropped, then PATTERN_STATE_MAX_CHANGES records of
+ * (frame, order, pattern, row, speed), all 32-bit; see pattern_state.h
+ * @return Pointer to the pattern state block
+ */
+PatternState* mpt_get_pattern_state()
+{
+    return &g_pattern.state;
+}
+
+/**
+ * Get render deadline statistics
+ * Layout: calls, over50, over80, over100, worstPermille, then
+ * RENDER_STATS_BUCKETS histogram counts (all uint32, see render_stats.h)
+ * @return Pointer to the statistics block
+ */
+RenderStats* mpt_stats_get()
+{
+    return &g_renderStats;
+}
+
+/**
+ * Record a render call made outside the adapter
+ * libopenmpt.ts playback calls the C API directly and reports its timing here
+ * @param renderMs Time spent rendering in milliseconds
+ * @param frames Frames produced
+ * @param sampleRate Output sample rate
+ */
+void mpt_stats_record(double renderMs, int frames, int sampleRate)
+{
+    renderStatsRecord(g_renderStats, renderMs * 1000.0, frames, sampleRate);
+    qualityRecord(g_quality, renderMs * 1000.0, frames, sampleRate);
+}
+
+/**
+ * Let render cost drive the interpolation quality
+ * Under sustained load the sinc filter is replaced by linear
+ * interpolation; it returns after a few seconds of headroom
+ * @param enabled 1 to adapt, 0 to return to and stay at full quality
+ */
+void mpt_set_adaptive_quality(int enabled)
+{
+    qualityConfigure(g_quality, enabled != 0, QUALITY_LEVELS - 1);
+    if (g_module) {
+        applyQuality(g_module);
+    }
+}
+
+/**
+ * Get the current quality level
+ * @return 0 = full quality, 1 = linear interpolation
+ */
+int mpt_get_quality_level()
+{
+    return g_quality.level;
+}
+
+/**
+ * Apply the current quality level to a module rendered outside the adapter
+ * libopenmpt.ts playback calls this when mpt_get_quality_level changes
+ * @param mod Module handle from openmpt_module_create_from_memory2
+ * @return Current quality level
+ */
+int mpt_apply_quality(openmpt_module* mod)
+{
+    if (mod) {
+        applyQuality(mod);
+    }
+    return g_quality.level;
+}
+
+/**
+ * Reset render deadline statistics
+ */
+void mpt_stats_reset()
+{
+    renderStatsReset(g_renderStats);
+}
+
+/**
+ * Start or stop recording the render timeline
+ * Spans: render, load, seek, export (per chunk) and overview
+ * @param capacity Events kept in the ring (oldest dropped), 0 = stop and free
+ */
+void mpt_trace_enable(int capacity)
+{
+    try {
+        traceEnable(g_trace, capacity);
+    } catch (...) {
+        traceEnable(g_trace, 0);
+    }
+    if (capacity <= 0) {
+        std::string().swap(g_traceJson);
+    }
+}
+
+/**
+ * Drop recorded spans, keep recording
+ */
+void mpt_trace_clear()
+{
+    traceClear(g_trace);
+}
+
+/**
+ * Export recorded spans as Chrome trace-event JSON
+ * @return NUL-terminated JSON, valid until the next export or disable
+ */
+const char* mpt_trace_export()
+{
+    try {
+        traceExportJson(g_trace, g_traceJson, "libopenmpt");
+    } catch (...) {
+        std::string().swap(g_traceJson);
+    }
+    return g_traceJson.c_str();
+}
+
 } // extern "C"
@@ -0,0 +1,133 @@
+/**
+ * libopenmpt build comparison
+ *
+ * Renders every tracker module in a directory through one or more builds
+ * of libopenmpt.js (scalar / SIMD, JS / WASM exceptions) and prints the
+ * .wasm size and render speed of each, so build flag changes come with
+ * numbers.
+ *
+ * Usage: node bench.mjs [--seconds=N] <music_dir> <build.js>...
+ *   --seconds  Render length per module (default 60, less if it ends first)
+ *
+ * Example:
+ *   EXCEPTIONS=js ./build.sh && cp dist/libopenmpt.js dist/libopenmpt.wasm /tmp/js/
+ *   ./build.sh && ./build.sh simd
+ *   node bench.mjs ../../public /tmp/js/libopenmpt.js dist/libopenmpt.js dist/libopenmpt-simd.js
+ */
+
+import { readdirSync, readFileSync, statSync } from 'node:fs';
+import { createRequire } from 'node:module';
+import path from 'node:path';
+import { performance } from 'node:perf_hooks';
+
+const SAMPLE_RATE = 48000;
+const BLOCK_FRAMES = 1024;
+const DEFAULT_SECONDS = 60;
+const WARMUP_SECONDS = 5;
+const MODULE_EXTENSIONS = ['mod', 's3m', 'xm', 'it', 'mptm', 'mtm', '669', 'stm', 'med', 'okt', 'ult', 'far'];
+
+const require = createRequire(import.meta.url);
+
+/**
+ * Instantiate an Emscripten MODULARIZE build
+ * Evaluated as CommonJS, since the app's package.json makes .js files ESM
+ */
+async function loadBuild(file) {
+  const dir = path.dirname(path.resolve(file));
+  const source = readFileSync(file, 'utf8');
+  const module = { exports: {} };
+  new Function('module', 'exports', 'require', '__filename', '__dirname', source)(
+    module, module.exports, require, file, dir);
+  return module.exports({ locateFile: (f) => path.join(dir, f) });
+}
+
+/**
+ * Render one module
+ * @returns Frames rendered and milliseconds spent in the read calls
+ */
+function render(mpt, data, maxFrames) {
+  const dataPtr = mpt._malloc(data.length);
+  mpt.HEAPU8.set(data, dataPtr);
+  const mod = mpt._openmpt_module_create_from_memory2(dataPtr, data.length, 0, 0, 0, 0, 0, 0, 0);
+  mpt._free(dataPtr);
+  if (!mod) {
+    return null;
+  }
+  mpt._openmpt_module_set_repeat_count(mod, 0);
+
+  const buffer = mpt._malloc(BLOCK_FRAMES * 2 * 4);
+  let frames = 0;
+  const start = performance.now();
+  while (frames < maxFrames) {
+    const read = mpt._openmpt_module_read_interleaved_float_stereo(mod, SAMPLE_RATE, BLOCK_FRAMES, buffer);
+    if (read === 0) {
+      break;
+    }
+    frames += read;
+  }
+  const ms = performance.now() - start;
+
+  mpt._free(buffer);
+  mpt._openmpt_module_destroy(mod);
+  return { frames, ms };
+}
+
+async function main() {
+  let seconds = DEFAULT_SECONDS;
+  const args = [];
+  for (const arg of process.argv.slice(2)) {
+    if (arg.startsWith('--seconds=')) {
+      seconds = Number(arg.slice(10)) || DEFAULT_SECONDS;
+    } else {
+      args.push(arg);
+    }
+  }
+  const [musicDir, ...builds] = args;
+  if (!musicDir || builds.length === 0) {
+    console.error('Usage: node bench.mjs [--seconds=N] <music_dir> <build.js>...');
+    process.exit(1);
+  }
+
+  const files = readdirSync(musicDir)
+    .filter((name) => MODULE_EXTENSIONS.includes(path.extname(name).slice(1).toLowerCase()))
+    .sort();
+  if (files.length === 0) {
+    console.error(`No tracker modules in ${musicDir}`);
+    process.exit(1);
+  }
+  const songs = files.map((name) => ({ name, data: readFileSync(path.join(musicDir, name)) }));
+  const maxFrames = seconds * SAMPLE_RATE;
+
+  const results = [];
+  for (const build of builds) {
+    const wasm = build.replace(/\.js$/, '.wasm');
+    const mpt = await loadBuild(build);
+
+    // Untimed warm-up so the engine has compiled the hot paths of every song
+    for (const song of songs) {
+      render(mpt, song.data, WARMUP_SECONDS * SAMPLE_RATE);
+    }
+
+    let frames = 0;
+    let ms = 0;
+    for (const song of songs) {
+      const result = render(mpt, song.data, maxFrames);
+      if (!result) {
+        console.error(`${build}: cannot load ${song.name}`);
+        continue;
+      }
+      frames += result.frames;
+      ms += result.ms;
+      console.log(`${build}\t${song.name}\t${(result.frames / SAMPLE_RATE / (result.ms / 1000)).toFixed(1)}x realtime`);
+    }
+    results.push({ build, size: statSync(wasm).size, speed: frames / SAMPLE_RATE / (ms / 1000), ms });
+  }
+
+  console.log('');
+  console.log('build\twasm bytes\trender ms\tx realtime');
+  for (const r of results) {
+    console.log(`${r.build}\t${r.size}\t${r.ms.toFixed(0)}\t${r.speed.toFixed(1)}`);
+  }
+}
+
+main();
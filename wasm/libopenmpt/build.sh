@@ -1,6 +1,12 @@
 #!/bin/bash
 # libopenmpt WASM Build Script
 # Uses official Makefile with Emscripten support
+#
+# Usage: ./build.sh          libopenmpt.js (scalar, runs everywhere)
+#        ./build.sh simd     libopenmpt-simd.js (WASM SIMD, see below)
+#
+# EXCEPTIONS=wasm (default) uses native WASM exception handling;
+# EXCEPTIONS=js uses Emscripten's JS emulation for runtimes without it
 
 set -e
 
@@ -10,6 +16,41 @@ cd "$SCRIPT_DIR"
 LIBOPENMPT_VERSION="0.8.0+release"
 LIBOPENMPT_URL="https://lib.openmpt.org/files/libopenmpt/src/libopenmpt-${LIBOPENMPT_VERSION}.makefile.tar.gz"
 
+VARIANT="${1:-scalar}"
+
+# SIMD variant: -msimd128 lets the compiler vectorize the mixer and
+# resampler loops. -msse2 is not passed: libopenmpt gates its SSE
+# intrinsics on its own architecture detection, not on __SSE2__ alone, so
+# defining it does not show they are compiled for wasm32. The build
+# reports how many SIMD instructions it ended up with; compare speed
+# against the scalar build with bench.mjs.
+# Needs WASM SIMD in the browser (Chrome 91, Firefox 89, Safari 16.4);
+# libopenmpt.ts falls back to the scalar build elsewhere.
+SIMD_FLAGS=""
+OUTPUT_NAME="libopenmpt"
+if [ "$VARIANT" = "simd" ]; then
+    SIMD_FLAGS="-msimd128"
+    OUTPUT_NAME="libopenmpt-simd"
+elif [ "$VARIANT" != "scalar" ]; then
+    echo "Usage: $0 [simd]"
+    exit 1
+fi
+
+# The JS emulation routes every call that may throw through an invoke
+# trampoline in JS, mixer loops included; native exceptions cost nothing
+# until thrown. Exceptions never leave adapter.cpp / the libopenmpt C API,
+# so only the runtime requirement differs (Chrome 95, Firefox 100, Safari 15.2).
+# bench.mjs compares the size and speed of builds in the two modes
+EXCEPTIONS="${EXCEPTIONS:-wasm}"
+if [ "$EXCEPTIONS" = "wasm" ]; then
+    EH_FLAGS="-fwasm-exceptions"
+elif [ "$EXCEPTIONS" = "js" ]; then
+    EH_FLAGS="-s DISABLE_EXCEPTION_CATCHING=0"
+else
+    echo "EXCEPTIONS must be wasm or js"
+    exit 1
+fi
+
 # Check if emcc is available
 if ! command -v emcc &> /dev/null; then
     echo "Error: Emscripten (emcc) not found. Please install emsdk first."
@@ -19,7 +60,7 @@ if ! command -v emcc &> /dev/null; then
     exit 1
 fi
 
-echo "=== libopenmpt WASM Build ==="
+echo "=== libopenmpt WASM Build ($VARIANT, $EXCEPTIONS exceptions) ==="
 echo "Using Emscripten: $(emcc --version | head -1)"
 
 # Create directories
@@ -38,55 +79,79 @@ fi
 
 LIBOPENMPT_SRC="src/libopenmpt-${LIBOPENMPT_VERSION}"
 
+# libopenmpt's Emscripten config enables the JS emulation itself, which
+# emcc rejects together with -fwasm-exceptions; build from a copy of it
+# with that flag swapped for the selected mode
+CONFIG_MK="$LIBOPENMPT_SRC/build/make/config-emscripten.mk"
+EH_PATTERN="-s \{0,1\}DISABLE_EXCEPTION_CATCHING=0"
+if [ ! -f "$CONFIG_MK.orig" ]; then
+    if [ ! -f "$CONFIG_MK" ]; then
+        echo "Error: $CONFIG_MK not found"
+        exit 1
+    fi
+    cp "$CONFIG_MK" "$CONFIG_MK.orig"
+fi
+if ! grep -q -e "$EH_PATTERN" "$CONFIG_MK.orig"; then
+    echo "Error: DISABLE_EXCEPTION_CATCHING=0 not found in $CONFIG_MK;"
+    echo "  libopenmpt ${LIBOPENMPT_VERSION} changed its Emscripten config, update the rewrite above"
+    exit 1
+fi
+sed "s/$EH_PATTERN/$EH_FLAGS/g" "$CONFIG_MK.orig" > "$CONFIG_MK"
+
 echo ""
 echo "=== Building libopenmpt with Emscripten ==="
 cd "$LIBOPENMPT_SRC"
 
-# Clean previous build
+# Clean previous build (the other variant's objects must not be reused)
 make CONFIG=emscripten EMSCRIPTEN_TARGET=wasm clean || true
 
-# Build with Emscripten (WASM target with MODULARIZE for browser use)
+# Build libopenmpt as a static library with Emscripten
 # NO_ZLIB=1 NO_MPG123=1 NO_OGG=1 NO_VORBIS=1 NO_VORBISFILE=1 - disable optional dependencies
-# Add MODULARIZE=1 for proper browser module loading
+# SHARED_LIB=0 STATIC_LIB=1 - the WASM module is linked below together with adapter.cpp
+# Extra flags go through the environment so the Makefile still appends its own
+CFLAGS="$SIMD_FLAGS" CXXFLAGS="$SIMD_FLAGS $EH_FLAGS" \
 make CONFIG=emscripten EMSCRIPTEN_TARGET=wasm \
     NO_ZLIB=1 NO_MPG123=1 NO_OGG=1 NO_VORBIS=1 NO_VORBISFILE=1 NO_MINIMP3=1 \
-    EXAMPLES=0 OPENMPT123=0 TEST=0 \
-    LDFLAGS="-s MODULARIZE=1 -s EXPORT_NAME='libopenmpt' -s WASM=1 -s ALLOW_MEMORY_GROWTH=1 -s DISABLE_EXCEPTION_CATCHING=0 -s ERROR_ON_UNDEFINED_SYMBOLS=1 -s EXPORTED_FUNCTIONS=\"['_malloc','_free']\" -s EXPORTED_RUNTIME_METHODS=\"['HEAPU8','HEAPF32','UTF8ToString','stringToUTF8','lengthBytesUTF8']\"" \
+    EXAMPLES=0 OPENMPT123=0 TEST=0 SHARED_LIB=0 STATIC_LIB=1 \
     -j$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 4)
 
 cd "$SCRIPT_DIR"
 
 echo ""
-echo "=== Copying WASM files ==="
+echo "=== Building adapter ==="
+mkdir -p build
+emcc -O3 -std=c++17 $SIMD_FLAGS $EH_FLAGS -I"$LIBOPENMPT_SRC/libopenmpt" -I../common -c adapter.cpp -o build/adapter.o
 
-# Find and copy the built files
-if [ -f "$LIBOPENMPT_SRC/bin/libopenmpt.js" ]; then
-    cp "$LIBOPENMPT_SRC/bin/libopenmpt.js" dist/
-    echo "Copied libopenmpt.js"
-fi
-
-if [ -f "$LIBOPENMPT_SRC/bin/libopenmpt.wasm" ]; then
-    cp "$LIBOPENMPT_SRC/bin/libopenmpt.wasm" dist/
-    echo "Copied libopenmpt.wasm"
-fi
-
-# Alternative location
-if [ -f "$LIBOPENMPT_SRC/bin/wasm/libopenmpt.js" ]; then
-    cp "$LIBOPENMPT_SRC/bin/wasm/libopenmpt.js" dist/
-    echo "Copied libopenmpt.js from wasm/"
-fi
-
-if [ -f "$LIBOPENMPT_SRC/bin/wasm/libopenmpt.wasm" ]; then
-    cp "$LIBOPENMPT_SRC/bin/wasm/libopenmpt.wasm" dist/
-    echo "Copied libopenmpt.wasm from wasm/"
-fi
+echo ""
+echo "=== Linking WASM module ==="
+
+# libopenmpt C API (used directly by libopenmpt.ts for playback)
+OPENMPT_EXPORTS="'_openmpt_module_create_from_memory2','_openmpt_module_destroy','_openmpt_module_read_interleaved_float_stereo','_openmpt_module_get_position_seconds','_openmpt_module_get_duration_seconds','_openmpt_module_set_position_seconds','_openmpt_module_get_metadata','_openmpt_module_set_repeat_count','_openmpt_module_set_render_param','_openmpt_free_string'"
+
+# Adapter API (adapter.cpp)
+ADAPTER_EXPORTS="'_mpt_init','_mpt_teardown','_mpt_load_file','_mpt_compute_audio_samples','_mpt_get_audio_buffer','_mpt_get_audio_buffer_frames','_mpt_get_position_seconds','_mpt_get_duration_seconds','_mpt_set_position_seconds','_mpt_get_track_info','_mpt_set_repeat_count','_mpt_rewind','_mpt_get_sample_rate','_mpt_render_overview','_mpt_get_overview_buffer','_mpt_get_overview_buckets','_mpt_export_begin','_mpt_export_render','_mpt_export_get_buffer','_mpt_export_get_length','_mpt_export_end','_mpt_trace_enable','_mpt_trace_clear','_mpt_trace_export','_mpt_stats_get','_mpt_stats_record','_mpt_stats_reset','_mpt_get_state_block','_mpt_publish_state','_mpt_set_adaptive_quality','_mpt_get_quality_level','_mpt_apply_quality','_mpt_read_block','_mpt_seek','_mpt_get_pattern_state','_mpt_set_pattern_tracking'"
+
+emcc -O3 $SIMD_FLAGS $EH_FLAGS \
+    build/adapter.o \
+    "$LIBOPENMPT_SRC/bin/libopenmpt.a" \
+    -s WASM=1 \
+    -s MODULARIZE=1 \
+    -s EXPORT_NAME="libopenmpt" \
+    -s EXPORTED_FUNCTIONS="['_malloc','_free',$OPENMPT_EXPORTS,$ADAPTER_EXPORTS]" \
+    -s EXPORTED_RUNTIME_METHODS="['HEAPU8','HEAPU32','HEAPF32','UTF8ToString','stringToUTF8','lengthBytesUTF8']" \
+    -s ALLOW_MEMORY_GROWTH=1 \
+    -s ERROR_ON_UNDEFINED_SYMBOLS=1 \
+    -o dist/$OUTPUT_NAME.js
 
 echo ""
 echo "=== Build complete ==="
 echo "Output files:"
 ls -la dist/ 2>/dev/null || echo "No files in dist/"
+echo "Code size: $(wc -c < dist/$OUTPUT_NAME.wasm) bytes ($OUTPUT_NAME.wasm, $EXCEPTIONS exceptions)"
 
-# Show location of all .js and .wasm files in bin
-echo ""
-echo "Files in bin directory:"
-find "$LIBOPENMPT_SRC/bin" -name "*.js" -o -name "*.wasm" 2>/dev/null || true
+# binaryen ships with Emscripten; count the v128 instructions that made it in
+WASM_DIS="$(dirname "$(command -v emcc)")/../bin/wasm-dis"
+if [ -x "$WASM_DIS" ]; then
+    echo "SIMD instructions: $("$WASM_DIS" dist/$OUTPUT_NAME.wasm | grep -cE '(v128|[if](8x16|16x8|32x4|64x2))\.')"
+fi
+echo "Compare builds with: node bench.mjs ../../public dist/*.js"
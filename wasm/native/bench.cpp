@@ -0,0 +1,414 @@
+/**
+ * Engine microbenchmarks
+ *
+ * Times the hot paths of the AdPlug engine in isolation so a regression
+ * can be pinned to one component instead of "playback got slower":
+ *   - Nuked OPL3 sample generation (OPL2 and OPL3 modes)
+ *   - OPL register writes
+ *   - CPlayer::update() per tick for each supported format
+ *   - binistream read throughput
+ *   - CProvider_Memory::open lookup
+ *   - CAdPlug::factory format dispatch
+ *
+ * Usage: bench [--filter=substring] [--min-time=seconds] [music_dir]
+ *
+ * The output mirrors Google Benchmark (name, time per iteration,
+ * iteration count) so results can be compared with the same tooling.
+ */
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdlib>
+
+// Pull in the adapter itself so its internal file provider can be timed
+#include "../adplug/adapter.cpp"
+
+#include "nukedopl.h"
+#include "silentopl.h"
+#include "fileutil.h"
+
+// Formats whose player update() is timed, with their file extensions
+static const char* const BENCH_FORMATS[] = { "ims", "rol", "vgm", "hsc", "a2m" };
+
+// Size of the buffer read back by the binistream benchmarks
+static const size_t STREAM_BENCH_BYTES = 1 << 20;
+
+// Sink that keeps the optimizer from discarding benchmark results
+static volatile int64_t g_benchSink = 0;
+
+struct Benchmark {
+    std::string name;
+    std::function<void()> setup;       // Untimed, before each timed run (may be empty)
+    std::function<void(uint64_t iterations)> run;
+    std::function<void()> teardown;    // Untimed, after each timed run (may be empty)
+    double bytesPerIteration;  // 0 if throughput is not meaningful
+};
+
+static std::vector<Benchmark> g_benchmarks;
+
+static void addBenchmark(const std::string& name,
+                         std::function<void(uint64_t)> run,
+                         double bytesPerIteration = 0)
+{
+    g_benchmarks.push_back({ name, nullptr, run, nullptr, bytesPerIteration });
+}
+
+/**
+ * Add a benchmark whose state is built and torn down outside the timed
+ * region (players, chips), so only the loop in run is measured
+ */
+static void addFixtureBenchmark(const std::string& name,
+                                std::function<void()> setup,
+                                std::function<void(uint64_t)> run,
+                                std::function<void()> teardown = nullptr)
+{
+    g_benchmarks.push_back({ name, setup, run, teardown, 0 });
+}
+
+/**
+ * Run one benchmark, growing the iteration count until it takes at
+ * least minTime seconds, and print the result
+ */
+static void runBenchmark(const Benchmark& bench, double minTime)
+{
+    uint64_t iterations = 1;
+    double elapsed = 0;
+
+    for (;;) {
+        if (bench.setup) {
+            bench.setup();
+        }
+        auto start = std::chrono::steady_clock::now();
+        bench.run(iterations);
+        auto end = std::chrono::steady_clock::now();
+        elapsed = std::chrono::duration<double>(end - start).count();
+        if (bench.teardown) {
+            bench.teardown();
+        }
+
+        if (elapsed >= minTime || iterations >= (1ULL << 40)) {
+            break;
+        }
+        // Jump close to the target instead of doubling blindly
+        double scale = elapsed > 0 ? (minTime * 1.2) / elapsed : 10.0;
+        if (scale < 2.0) scale = 2.0;
+        if (scale > 100.0) scale = 100.0;
+        iterations = static_cast<uint64_t>(iterations * scale);
+    }
+
+    double nsPerIteration = elapsed * 1e9 / iterations;
+    printf("%-44s %12.1f ns %14llu", bench.name.c_str(), nsPerIteration,
+           static_cast<unsigned long long>(iterations));
+    if (bench.bytesPerIteration > 0) {
+        double mbPerSecond = bench.bytesPerIteration * iterations / elapsed / (1024.0 * 1024.0);
+        printf("  %9.1f MB/s", mbPerSecond);
+    }
+    printf("\n");
+}
+
+// ============================================================
+// OPL core
+// ============================================================
+
+// Operator register offsets of the first slot of each 2-op channel
+static const uint8_t OPL_SLOT_OFFSETS[9] = { 0, 1, 2, 8, 9, 10, 16, 17, 18 };
+
+/**
+ * Reset a chip and key on a sustained voice on every channel so the
+ * generator does real envelope and phase work
+ * @param chip Chip to set up
+ * @param opl3 Enable OPL3 mode and use all 18 channels
+ * @param sampleRate Output rate (49716 = native, no resampling)
+ */
+static void setupVoices(opl3_chip* chip, bool opl3, uint32_t sampleRate = 49716)
+{
+    OPL3_Reset(chip, sampleRate);
+    if (opl3) {
+        OPL3_WriteReg(chip, 0x105, 0x01);
+    }
+    OPL3_WriteReg(chip, 0x01, 0x20);
+
+    int channels = opl3 ? 18 : 9;
+    for (int ch = 0; ch < channels; ch++) {
+        uint16_t bank = ch >= 9 ? 0x100 : 0;
+        int index = ch % 9;
+        uint16_t op = bank | OPL_SLOT_OFFSETS[index];
+
+        OPL3_WriteReg(chip, op + 0x20, 0x21);  // Sustain, multiplier 1
+        OPL3_WriteReg(chip, op + 0x23, 0x21);
+        OPL3_WriteReg(chip, op + 0x40, 0x10);
+        OPL3_WriteReg(chip, op + 0x43, 0x00);
+        OPL3_WriteReg(chip, op + 0x60, 0xF4);
+        OPL3_WriteReg(chip, op + 0x63, 0xF4);
+        OPL3_WriteReg(chip, op + 0x80, 0x27);
+        OPL3_WriteReg(chip, op + 0x83, 0x27);
+        OPL3_WriteReg(chip, bank | (0xC0 + index), 0x3E);  // Both outputs, feedback 7
+        OPL3_WriteReg(chip, bank | (0xA0 + index), (0x40 + ch * 7) & 0xFF);
+        OPL3_WriteReg(chip, bank | (0xB0 + index), 0x20 | (4 << 2) | 0x01);
+    }
+}
+
+static void registerOplBenchmarks()
+{
+    static opl3_chip chip;
+
+    for (int mode = 0; mode < 2; mode++) {
+        bool opl3 = mode == 1;
+        std::string suffix = opl3 ? "OPL3" : "OPL2";
+
+        // One native-rate sample per iteration
+        addFixtureBenchmark("OPL3_Generate/" + suffix, [opl3]() {
+            setupVoices(&chip, opl3);
+        }, [](uint64_t iterations) {
+            int16_t buf[2];
+            int64_t sum = 0;
+            for (uint64_t i = 0; i < iterations; i++) {
+                OPL3_Generate(&chip, buf);
+                sum += buf[0];
+            }
+            g_benchSink = g_benchSink + sum;
+        });
+
+        // One 44.1kHz output sample per iteration (includes the resampler)
+        addFixtureBenchmark("OPL3_GenerateResampled/" + suffix, [opl3]() {
+            setupVoices(&chip, opl3, 44100);
+        }, [](uint64_t iterations) {
+            int16_t buf[2];
+            int64_t sum = 0;
+            for (uint64_t i = 0; i < iterations; i++) {
+                OPL3_GenerateResampled(&chip, buf);
+                sum += buf[0];
+            }
+            g_benchSink = g_benchSink + sum;
+        });
+    }
+
+    // Frequency/key-on writes as a player issues them every tick
+    addFixtureBenchmark("OPL3_WriteReg", []() {
+        setupVoices(&chip, true);
+    }, [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            int index = static_cast<int>(i % 9);
+            OPL3_WriteReg(&chip, 0xA0 + index, static_cast<uint8_t>(i));
+        }
+    });
+
+    addFixtureBenchmark("OPL3_WriteRegBuffered", []() {
+        setupVoices(&chip, true);
+    }, [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            int index = static_cast<int>(i % 9);
+            OPL3_WriteRegBuffered(&chip, 0xA0 + index, static_cast<uint8_t>(i));
+        }
+    });
+
+    // Full path through the adapter's OPL wrapper
+    static std::unique_ptr<CChanopl> chanopl;
+    addFixtureBenchmark("CChanopl::write", []() {
+        chanopl.reset(new CChanopl(44100));
+        chanopl->init();
+    }, [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            int index = static_cast<int>(i % 9);
+            chanopl->write(0xA0 + index, static_cast<int>(i & 0xFF));
+        }
+    }, []() {
+        chanopl.reset();
+    });
+}
+
+// ============================================================
+// Players, file provider and factory
+// ============================================================
+
+/**
+ * Find the first file with the given extension in a file list
+ * @return File name, or "" if none
+ */
+static std::string findByExtension(const std::vector<std::string>& names, const char* ext)
+{
+    for (const std::string& name : names) {
+        if (fileExtension(name) == ext) {
+            return name;
+        }
+    }
+    return "";
+}
+
+/**
+ * Load every file in the music directory into the adapter's file store
+ * @return Names of the files that were loaded
+ */
+static std::vector<std::string> loadMusicDirectory(const std::string& dir)
+{
+    std::vector<std::string> loaded;
+    for (const std::string& name : listDirectory(dir)) {
+        std::vector<uint8_t> data;
+        if (!readFile(dir + "/" + name, data) || data.empty()) {
+            continue;
+        }
+        emu_add_file(name.c_str(), data.data(), static_cast<int>(data.size()));
+        loaded.push_back(name);
+    }
+    return loaded;
+}
+
+// Player loaded outside the timed region of CPlayer::update
+struct PlayerFixture {
+    CSilentopl opl;
+    CPlayer* player = nullptr;
+};
+
+static void registerPlayerBenchmarks(const std::vector<std::string>& names)
+{
+    for (const char* ext : BENCH_FORMATS) {
+        std::string name = findByExtension(names, ext);
+        if (name.empty()) {
+            fprintf(stderr, "note: no .%s file in music directory, skipping\n", ext);
+            continue;
+        }
+
+        std::string upper = ext;
+        for (char& c : upper) c = static_cast<char>(c - 'a' + 'A');
+
+        // One player tick per iteration; the silent OPL isolates player logic
+        auto fixture = std::make_shared<PlayerFixture>();
+        addFixtureBenchmark("CPlayer::update/" + upper, [fixture, name]() {
+            fixture->player = CAdPlug::factory(name, &fixture->opl, CAdPlug::players, g_memProvider);
+        }, [fixture](uint64_t iterations) {
+            CPlayer* player = fixture->player;
+            if (!player) {
+                return;
+            }
+            for (uint64_t i = 0; i < iterations; i++) {
+                if (!player->update()) {
+                    player->rewind();
+                }
+            }
+        }, [fixture]() {
+            delete fixture->player;
+            fixture->player = nullptr;
+        });
+
+        // Format detection and load, including the loaders tried first
+        addBenchmark("CAdPlug::factory/" + upper, [name](uint64_t iterations) {
+            CSilentopl opl;
+            for (uint64_t i = 0; i < iterations; i++) {
+                CPlayer* player = CAdPlug::factory(name, &opl, CAdPlug::players, g_memProvider);
+                g_benchSink = g_benchSink + (player != nullptr);
+                delete player;
+            }
+        });
+    }
+
+    if (names.empty()) {
+        return;
+    }
+
+    // Exact key hit, and the case-insensitive scan that player bank lookups hit
+    std::string exact = names.back();
+    std::string folded = toLower(exact);
+    if (folded == exact) {
+        for (char& c : folded) {
+            if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        }
+    }
+
+    addBenchmark("CProvider_Memory::open/exact", [exact](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            binistream* f = g_memProvider.open(exact);
+            g_memProvider.close(f);
+        }
+    });
+
+    addBenchmark("CProvider_Memory::open/case_folded", [folded](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            binistream* f = g_memProvider.open(folded);
+            g_memProvider.close(f);
+        }
+    });
+
+    addBenchmark("CProvider_Memory::open/miss", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; i++) {
+            binistream* f = g_memProvider.open("does-not-exist.bnk");
+            g_benchSink = g_benchSink + (f != nullptr);
+        }
+    });
+}
+
+// ============================================================
+// binistream
+// ============================================================
+
+static void registerStreamBenchmarks()
+{
+    static std::vector<uint8_t> data(STREAM_BENCH_BYTES);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    static const unsigned int READ_SIZES[] = { 1, 2, 4 };
+    for (unsigned int size : READ_SIZES) {
+        // One pass over the whole buffer per iteration
+        addBenchmark("binistream::readInt/" + std::to_string(size), [size](uint64_t iterations) {
+            binisstream stream(data.data(), data.size());
+            int64_t sum = 0;
+            size_t reads = data.size() / size;
+            for (uint64_t i = 0; i < iterations; i++) {
+                stream.seek(0);
+                for (size_t r = 0; r < reads; r++) {
+                    sum += stream.readInt(size);
+                }
+            }
+            g_benchSink = g_benchSink + sum;
+        }, static_cast<double>(STREAM_BENCH_BYTES));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::string musicDir = "../../public";
+    double minTime = 0.5;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = arg.substr(9);
+        } else if (arg.compare(0, 11, "--min-time=") == 0) {
+            minTime = atof(arg.c_str() + 11);
+        } else if (arg == "--help" || arg == "-h") {
+            printf("Usage: %s [--filter=substring] [--min-time=seconds] [music_dir]\n", argv[0]);
+            return 0;
+        } else {
+            musicDir = arg;
+        }
+    }
+
+    if (emu_init(44100) != 0) {
+        fprintf(stderr, "emu_init failed\n");
+        return 1;
+    }
+
+    std::vector<std::string> names = loadMusicDirectory(musicDir);
+    if (names.empty()) {
+        fprintf(stderr, "note: no files in '%s', player benchmarks skipped\n", musicDir.c_str());
+    }
+
+    registerOplBenchmarks();
+    registerPlayerBenchmarks(names);
+    registerStreamBenchmarks();
+
+    printf("%-44s %15s %14s\n", "Benchmark", "Time", "Iterations");
+    printf("%s\n", std::string(88, '-').c_str());
+    for (const Benchmark& bench : g_benchmarks) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        runBenchmark(bench, minTime);
+    }
+
+    emu_teardown();
+    return 0;
+}
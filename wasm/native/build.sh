@@ -0,0 +1,144 @@
+#!/bin/bash
+# Native Build Script
+# Builds adplug 2.4 + the WASM adapter with the host compiler for
+# benchmarks and command-line tools (no Emscripten required)
+#
+# Usage: ./build.sh          bench, render_check (gcc by default)
+#        ./build.sh fuzz     fuzz_adplug (clang, libFuzzer + ASan)
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+cd "$SCRIPT_DIR"
+
+ADPLUG_DIR="$SCRIPT_DIR/../adplug"
+
+MODE="${1:-tools}"
+
+# Compiler flags
+CFLAGS="-O2 -g -DNDEBUG -DSTDC_HEADERS=1 -Dstricmp=strcasecmp"
+CXXFLAGS="-O2 -g -DNDEBUG -std=c++17 -DSTDC_HEADERS=1 -Dstricmp=strcasecmp"
+OBJ_DIR="build/obj"
+
+if [ "$MODE" = "fuzz" ]; then
+    # Everything is instrumented so the fuzzer sees coverage inside AdPlug
+    CC="${CC:-clang}"
+    CXX="${CXX:-clang++}"
+    CFLAGS="$CFLAGS -fsanitize=fuzzer-no-link,address"
+    CXXFLAGS="$CXXFLAGS -fsanitize=fuzzer-no-link,address"
+    OBJ_DIR="build/fuzz-obj"
+else
+    CC="${CC:-gcc}"
+    CXX="${CXX:-g++}"
+fi
+
+# Uses the same AdPlug / libbinio checkout as the WASM build
+if [ ! -d "$ADPLUG_DIR/src/src" ] || [ ! -d "$ADPLUG_DIR/libbinio/src" ]; then
+    echo "Error: AdPlug sources not found. Clone them first (see ../adplug/README.md)."
+    exit 1
+fi
+
+echo "=== AdPlug Native Build ==="
+echo "Using compiler: $($CXX --version | head -1)"
+
+mkdir -p "$OBJ_DIR"
+
+# Apply local patches to the AdPlug sources (same as the WASM build)
+cp "$ADPLUG_DIR"/patches/*.cpp "$ADPLUG_DIR/src/src/"
+
+ADPLUG_INCLUDES="-I$ADPLUG_DIR/src/src -isystem $ADPLUG_DIR/libbinio/src"
+COMMON_INCLUDES="-I$SCRIPT_DIR/../common"
+
+echo ""
+echo "=== Building libbinio ==="
+for src in binio.cpp binfile.cpp binwrap.cpp binstr.cpp; do
+    echo "  Compiling $src..."
+    $CXX $CXXFLAGS -I"$ADPLUG_DIR/libbinio/src" -c "$ADPLUG_DIR/libbinio/src/$src" -o "$OBJ_DIR/${src%.cpp}.o"
+done
+
+echo ""
+echo "=== Building adplug core ==="
+
+# Same source list as ../adplug/build.sh
+C_SOURCES="adlibemu.c debug.c depack.c fmopl.c nukedopl.c unlzh.c unlzss.c unlzw.c"
+for src in $C_SOURCES; do
+    echo "  Compiling $src..."
+    $CC $CFLAGS $ADPLUG_INCLUDES -c "$ADPLUG_DIR/src/src/$src" -o "$OBJ_DIR/${src%.c}.o"
+done
+
+CPP_SOURCES="
+sixdepack.cpp
+a2m.cpp a2m-v2.cpp adl.cpp adplug.cpp adtrack.cpp amd.cpp analopl.cpp
+bam.cpp bmf.cpp cff.cpp cmf.cpp cmfmcsop.cpp coktel.cpp composer.cpp
+d00.cpp database.cpp dfm.cpp diskopl.cpp dmo.cpp dro2.cpp dro.cpp dtm.cpp
+emuopl.cpp flash.cpp fmc.cpp fprovide.cpp got.cpp herad.cpp hsc.cpp hsp.cpp
+hybrid.cpp hyp.cpp imf.cpp jbm.cpp kemuopl.cpp ksm.cpp lds.cpp mad.cpp
+mdi.cpp mid.cpp mkj.cpp msc.cpp mtk.cpp mtr.cpp mus.cpp nemuopl.cpp
+pis.cpp player.cpp players.cpp plx.cpp protrack.cpp psi.cpp rad2.cpp
+rat.cpp raw.cpp rix.cpp rol.cpp s3m.cpp sa2.cpp sng.cpp sop.cpp
+surroundopl.cpp temuopl.cpp u6m.cpp vgm.cpp woodyopl.cpp xad.cpp xsm.cpp
+"
+
+for src in $CPP_SOURCES; do
+    echo "  Compiling $src..."
+    $CXX $CXXFLAGS $ADPLUG_INCLUDES -c "$ADPLUG_DIR/src/src/$src" -o "$OBJ_DIR/${src%.cpp}.o"
+done
+
+echo "  Compiling chanopl.cpp..."
+$CXX $CXXFLAGS $ADPLUG_INCLUDES -c "$ADPLUG_DIR/chanopl.cpp" -o "$OBJ_DIR/chanopl.o"
+echo "  Compiling qualityopl.cpp..."
+$CXX $CXXFLAGS $ADPLUG_INCLUDES -c "$ADPLUG_DIR/qualityopl.cpp" -o "$OBJ_DIR/qualityopl.o"
+echo "  Compiling reglog.cpp..."
+$CXX $CXXFLAGS $ADPLUG_INCLUDES -c "$ADPLUG_DIR/reglog.cpp" -o "$OBJ_DIR/reglog.o"
+
+if [ "$MODE" = "fuzz" ]; then
+    echo ""
+    echo "=== Building fuzzer ==="
+    # fuzz_adplug includes adapter.cpp itself to reach its internal state
+    echo "  Linking fuzz_adplug..."
+    $CXX $CXXFLAGS -fsanitize=fuzzer,address $ADPLUG_INCLUDES $COMMON_INCLUDES \
+        fuzz_adplug.cpp "$OBJ_DIR"/*.o -o build/fuzz_adplug
+
+    echo ""
+    echo "=== Build complete ==="
+    ls -la build/fuzz_adplug
+    exit 0
+fi
+
+echo ""
+echo "=== Building adapters ==="
+echo "  Compiling adplug/adapter.cpp..."
+$CXX $CXXFLAGS $ADPLUG_INCLUDES $COMMON_INCLUDES -c "$ADPLUG_DIR/adapter.cpp" -o build/adplug_adapter.o
+
+# libopenmpt comes from the system (e.g. libopenmpt-dev); optional
+MPT_FLAGS=""
+MPT_OBJECTS=""
+if pkg-config --exists libopenmpt 2>/dev/null; then
+    echo "  Compiling libopenmpt/adapter.cpp..."
+    # adapter.cpp includes "libopenmpt.h" directly, not <libopenmpt/libopenmpt.h>
+    MPT_INCLUDES="-I$(pkg-config --variable=includedir libopenmpt)/libopenmpt $(pkg-config --cflags libopenmpt)"
+    $CXX $CXXFLAGS $MPT_INCLUDES $COMMON_INCLUDES \
+        -c "$SCRIPT_DIR/../libopenmpt/adapter.cpp" -o build/mpt_adapter.o
+    MPT_FLAGS="-DHAVE_LIBOPENMPT"
+    MPT_OBJECTS="build/mpt_adapter.o $(pkg-config --libs libopenmpt)"
+else
+    echo "  libopenmpt not found via pkg-config, tracker formats disabled"
+fi
+
+echo ""
+echo "=== Building tools ==="
+
+# bench includes adapter.cpp itself to reach its internal state
+echo "  Linking bench..."
+$CXX $CXXFLAGS $ADPLUG_INCLUDES $COMMON_INCLUDES bench.cpp "$OBJ_DIR"/*.o -o build/bench
+
+echo "  Linking render_check..."
+$CXX $CXXFLAGS $MPT_FLAGS $ADPLUG_INCLUDES render_check.cpp build/adplug_adapter.o "$OBJ_DIR"/*.o $MPT_OBJECTS -o build/render_check
+
+echo "  Linking render_daemon..."
+$CXX $CXXFLAGS $MPT_FLAGS $COMMON_INCLUDES render_daemon.cpp build/adplug_adapter.o "$OBJ_DIR"/*.o $MPT_OBJECTS -o build/render_daemon
+
+echo ""
+echo "=== Build complete ==="
+echo "Output files:"
+ls -la build/
@@ -0,0 +1,46 @@
+/**
+ * Adapter entry points used by the native tools
+ *
+ * Declarations for the extern "C" functions of ../adplug/adapter.cpp and
+ * ../libopenmpt/adapter.cpp, which are linked in as separate objects.
+ * The libopenmpt side is only available when built with HAVE_LIBOPENMPT.
+ */
+
+#ifndef NATIVE_ENGINES_H
+#define NATIVE_ENGINES_H
+
+#include <cstdint>
+
+extern "C" {
+
+// AdPlug adapter
+int emu_init(int sampleRate);
+void emu_teardown();
+int emu_add_file(const char* filename, const uint8_t* data, int size);
+int emu_load_file(const char* filename, const uint8_t* data, int size);
+int emu_compute_audio_samples();
+int16_t* emu_get_audio_buffer();
+int emu_get_audio_buffer_length();
+unsigned long emu_get_current_position();
+unsigned long emu_get_max_position();
+void emu_set_loop_enabled(int enabled);
+void emu_rewind();
+void emu_trace_enable(int capacity);
+const char* emu_trace_export();
+
+#ifdef HAVE_LIBOPENMPT
+// libopenmpt adapter
+int mpt_init(int sampleRate);
+void mpt_teardown();
+int mpt_load_file(const char* filename, const uint8_t* data, int size);
+int mpt_compute_audio_samples();
+float* mpt_get_audio_buffer();
+int mpt_get_audio_buffer_frames();
+void mpt_set_repeat_count(int count);
+void mpt_trace_enable(int capacity);
+const char* mpt_trace_export();
+#endif
+
+}
+
+#endif // NATIVE_ENGINES_H
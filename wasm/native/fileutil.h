@@ -0,0 +1,82 @@
+/**
+ * File helpers shared by the native tools
+ */
+
+#ifndef NATIVE_FILEUTIL_H
+#define NATIVE_FILEUTIL_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <dirent.h>
+
+/**
+ * Read a whole file into memory
+ * @param path File path
+ * @param out Receives the file contents
+ * @return true on success
+ */
+static inline bool readFile(const std::string& path, std::vector<uint8_t>& out)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(f);
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    bool ok = size == 0 || fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+/**
+ * Lowercase file extension without the dot ("" if none)
+ */
+static inline std::string fileExtension(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return "";
+    }
+    std::string ext = path.substr(dot + 1);
+    for (size_t i = 0; i < ext.length(); i++) {
+        if (ext[i] >= 'A' && ext[i] <= 'Z') {
+            ext[i] = ext[i] - 'A' + 'a';
+        }
+    }
+    return ext;
+}
+
+/**
+ * List regular file names in a directory, sorted
+ * @param dir Directory path
+ * @return File names (without the directory part)
+ */
+static inline std::vector<std::string> listDirectory(const std::string& dir)
+{
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return names;
+    }
+    while (struct dirent* entry = readdir(d)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        names.push_back(entry->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+#endif // NATIVE_FILEUTIL_H
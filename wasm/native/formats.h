@@ -0,0 +1,71 @@
+/**
+ * Engine routing and content hashing shared by the native tools
+ */
+
+#ifndef NATIVE_FORMATS_H
+#define NATIVE_FORMATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "fileutil.h"
+
+// Same routing as app/lib/format-detection.ts, limited to what we ship
+static const char* const ADPLUG_EXTENSIONS[] = {
+    "ims", "rol", "vgm", "vgz", "cmf", "dro", "raw", "laa", "imf", "a2m",
+    "adl", "amd", "bam", "cff", "d00", "dfm", "dmo", "dtm", "got", "hsc",
+    "hsp", "hsq", "jbm", "ksm", "lds", "mad", "mdi", "mid", "mkj", "msc",
+    "mtk", "mtr", "mus", "pis", "plx", "rad", "rix", "sa2", "sat", "sci",
+    "sdb", "sng", "sop", "sqx", "xad", "xms", "xsm", "ha2", "agd",
+};
+static const char* const MPT_EXTENSIONS[] = {
+    "mod", "s3m", "xm", "it", "mptm", "mtm", "669", "stm", "med", "okt", "ult", "far",
+};
+
+enum Engine { ENGINE_NONE, ENGINE_ADPLUG, ENGINE_MPT };
+
+template <size_t N>
+static bool hasExtension(const char* const (&list)[N], const std::string& ext)
+{
+    for (size_t i = 0; i < N; i++) {
+        if (ext == list[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline Engine engineFor(const std::string& name)
+{
+    std::string ext = fileExtension(name);
+    if (hasExtension(ADPLUG_EXTENSIONS, ext)) {
+        return ENGINE_ADPLUG;
+    }
+    if (hasExtension(MPT_EXTENSIONS, ext)) {
+        return ENGINE_MPT;
+    }
+    return ENGINE_NONE;
+}
+
+static inline const char* engineName(Engine engine)
+{
+    return engine == ENGINE_MPT ? "libopenmpt" : "adplug";
+}
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+/**
+ * FNV-1a 64-bit hash
+ * @param hash Running hash to continue from (chains several buffers)
+ */
+static inline uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#endif // NATIVE_FORMATS_H
@@ -0,0 +1,169 @@
+/**
+ * libFuzzer harness for AdPlug loading and rendering cost
+ *
+ * Besides crashes, this looks for inputs that are merely slow: a loader,
+ * songlength() scan or player update() that takes super-linear time or
+ * never yields would freeze playback for a user-dropped file.
+ *
+ * Cost is fed back to libFuzzer through extra coverage counters: every
+ * new power-of-two bucket of load time, ticks per block or block render
+ * time counts as new coverage, so the fuzzer climbs toward expensive
+ * inputs instead of just new code paths. Inputs over the budgets below
+ * abort with a report, which makes libFuzzer save them as artifacts.
+ *
+ * The first input byte picks the file extension (and so the loader that
+ * CAdPlug::factory tries first); the rest is the file.
+ *
+ * Environment:
+ *   FUZZ_BANK_DIR         Directory whose BNK files are offered to every input
+ *   FUZZ_LOAD_BUDGET_MS   Max emu_load_file time (default 500)
+ *   FUZZ_BLOCK_BUDGET_MS  Max time for one render block (default 20)
+ *
+ * Build with ./build.sh fuzz, then e.g.:
+ *   ./build/fuzz_adplug -timeout=10 corpus/ ../../public/
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Pull in the adapter itself to see tick counts and time factory/songlength
+#include "../adplug/adapter.cpp"
+
+#include "silentopl.h"
+#include "fileutil.h"
+
+// Extensions selectable by the first input byte
+static const char* const FUZZ_EXTENSIONS[] = {
+    "vgm", "ims", "rol", "a2m", "hsc", "dro", "imf", "raw", "cmf", "d00",
+    "rad", "sa2", "amd", "dtm", "mtk", "s3m", "xad", "bam", "lds", "ksm",
+};
+static const int FUZZ_EXTENSION_COUNT = sizeof(FUZZ_EXTENSIONS) / sizeof(FUZZ_EXTENSIONS[0]);
+
+static const int FUZZ_SAMPLE_RATE = 44100;
+static const int FUZZ_MAX_BLOCKS = 2048;  // ~24s of audio per input
+
+// Cost buckets: [0,32) load time (us), [32,64) ticks per block, [64,96) block time (us)
+static const int COST_BUCKETS = 32;
+__attribute__((section("__libfuzzer_extra_counters")))
+static uint8_t g_costCounters[COST_BUCKETS * 3];
+
+static double g_loadBudgetMs = 500;
+static double g_blockBudgetMs = 20;
+static std::vector<std::pair<std::string, std::vector<uint8_t>>> g_banks;
+
+static int log2Bucket(uint64_t value)
+{
+    int bucket = 0;
+    while (value > 1 && bucket < COST_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Time factory and songlength() separately so a slow load report says
+ * which of the two is to blame
+ */
+static void reportSlowLoad(const std::string& name, double loadMs)
+{
+    CSilentopl opl;
+    auto start = std::chrono::steady_clock::now();
+    CPlayer* player = CAdPlug::factory(name, &opl, CAdPlug::players, g_memProvider);
+    double factoryMs = elapsedMs(start);
+
+    double songlengthMs = 0;
+    if (player) {
+        start = std::chrono::steady_clock::now();
+        player->songlength();
+        songlengthMs = elapsedMs(start);
+    }
+
+    fprintf(stderr, "==SLOW LOAD== %s: %.1f ms (factory %.1f ms, songlength %.1f ms, player %s)\n",
+            name.c_str(), loadMs, factoryMs, songlengthMs,
+            player ? player->gettype().c_str() : "none");
+    delete player;
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+    if (const char* value = getenv("FUZZ_LOAD_BUDGET_MS")) {
+        g_loadBudgetMs = atof(value);
+    }
+    if (const char* value = getenv("FUZZ_BLOCK_BUDGET_MS")) {
+        g_blockBudgetMs = atof(value);
+    }
+    if (const char* dir = getenv("FUZZ_BANK_DIR")) {
+        for (const std::string& name : listDirectory(dir)) {
+            if (fileExtension(name) != "bnk") {
+                continue;
+            }
+            std::vector<uint8_t> data;
+            if (readFile(std::string(dir) + "/" + name, data) && !data.empty()) {
+                g_banks.push_back({ name, data });
+            }
+        }
+    }
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size < 2) {
+        return 0;
+    }
+
+    std::string name = std::string("fuzz.") + FUZZ_EXTENSIONS[data[0] % FUZZ_EXTENSION_COUNT];
+    const uint8_t* file = data + 1;
+    int fileSize = static_cast<int>(size - 1);
+
+    emu_init(FUZZ_SAMPLE_RATE);
+    for (const auto& bank : g_banks) {
+        emu_add_file(bank.first.c_str(), bank.second.data(), static_cast<int>(bank.second.size()));
+    }
+
+    // Load covers factory dispatch, the loader and the songlength() scan
+    auto start = std::chrono::steady_clock::now();
+    int loaded = emu_load_file(name.c_str(), file, fileSize);
+    double loadMs = elapsedMs(start);
+    g_costCounters[log2Bucket(static_cast<uint64_t>(loadMs * 1000))] = 1;
+
+    if (loadMs > g_loadBudgetMs) {
+        reportSlowLoad(name, loadMs);
+        abort();
+    }
+    if (loaded != 0) {
+        return 0;
+    }
+
+    // Exercise looping players too, so a loop that never waits is found
+    emu_set_loop_enabled(data[0] & 0x80 ? 1 : 0);
+
+    for (int block = 0; block < FUZZ_MAX_BLOCKS; block++) {
+        unsigned long ticksBefore = g_currentTick;
+        start = std::chrono::steady_clock::now();
+        int ended = emu_compute_audio_samples();
+        double blockMs = elapsedMs(start);
+        unsigned long ticks = g_currentTick - ticksBefore;
+
+        g_costCounters[COST_BUCKETS + log2Bucket(ticks)] = 1;
+        g_costCounters[COST_BUCKETS * 2 + log2Bucket(static_cast<uint64_t>(blockMs * 1000))] = 1;
+
+        if (blockMs > g_blockBudgetMs) {
+            fprintf(stderr, "==SLOW BLOCK== %s (%s): block %d took %.1f ms, %lu ticks, refresh %.1f Hz\n",
+                    name.c_str(), g_type, block, blockMs, ticks, g_player->getrefresh());
+            abort();
+        }
+        if (ended) {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#!/bin/bash
+# Golden File Generator
+# Writes golden.txt from the engine of an earlier revision, so the
+# reference comes from the engine as it was before a refactor rather than
+# from the refactor itself
+#
+# Usage: ./golden.sh <revision> [music_dir]
+#   revision   Any git revision
+#   music_dir  Defaults to ../../public
+#
+# Revisions with wasm/native/render_check.cpp are built in a temporary
+# worktree (the AdPlug / libbinio checkout is copied in, libopenmpt is
+# picked up the same way as ./build.sh). Older revisions have no native
+# build, so their shipped public/*.wasm binaries are rendered with node
+# (golden_wasm.mjs).
+#
+# Either way the raw renders end up in build/render-check/, where
+# render_check looks for them to report the first differing sample.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+cd "$SCRIPT_DIR"
+
+ADPLUG_DIR="$SCRIPT_DIR/../adplug"
+REFERENCE_DIR="$SCRIPT_DIR/build/render-check"
+
+REVISION="$1"
+MUSIC_DIR="$(cd "${2:-../../public}" && pwd)"
+
+if [ -z "$REVISION" ]; then
+    echo "Usage: $0 <revision> [music_dir]"
+    exit 1
+fi
+
+COMMIT="$(git rev-parse --verify "$REVISION^{commit}")"
+SHORT="$(git rev-parse --short "$COMMIT")"
+
+echo "=== Golden File Generator ==="
+echo "Revision: $(git log -1 --format='%h %s' "$COMMIT")"
+
+rm -rf "$REFERENCE_DIR"
+mkdir -p "$REFERENCE_DIR"
+
+if ! git cat-file -e "$COMMIT:wasm/native/render_check.cpp" 2>/dev/null; then
+    if ! command -v node &> /dev/null; then
+        echo "Error: $REVISION has no render_check; rendering its public/*.wasm needs node."
+        exit 1
+    fi
+
+    WASM_DIR="$(mktemp -d)"
+    trap 'rm -rf "$WASM_DIR"' EXIT
+
+    for file in adplug.js adplug.wasm libopenmpt.js libopenmpt.wasm; do
+        if ! git cat-file -e "$COMMIT:public/$file" 2>/dev/null; then
+            echo "Error: $REVISION has neither render_check nor public/$file"
+            exit 1
+        fi
+        git cat-file blob "$COMMIT:public/$file" > "$WASM_DIR/$file"
+    done
+
+    echo ""
+    echo "=== Rendering reference (public/*.wasm) ==="
+    node golden_wasm.mjs "$WASM_DIR" "$MUSIC_DIR" "$SCRIPT_DIR/golden.txt" "$REFERENCE_DIR" \
+        "public/*.wasm of $SHORT"
+
+    echo ""
+    echo "Wrote $SCRIPT_DIR/golden.txt from $SHORT"
+    exit 0
+fi
+
+if [ ! -d "$ADPLUG_DIR/src/src" ] || [ ! -d "$ADPLUG_DIR/libbinio/src" ]; then
+    echo "Error: AdPlug sources not found. Clone them first (see ../adplug/README.md)."
+    exit 1
+fi
+
+WORKTREE="$(mktemp -d)"
+trap 'git worktree remove --force "$WORKTREE" >/dev/null 2>&1 || rm -rf "$WORKTREE"' EXIT
+
+git worktree add --detach "$WORKTREE" "$COMMIT" >/dev/null
+cp -R "$ADPLUG_DIR/src" "$ADPLUG_DIR/libbinio" "$WORKTREE/wasm/adplug/"
+
+echo ""
+"$WORKTREE/wasm/native/build.sh"
+
+echo ""
+echo "=== Rendering reference ==="
+(cd "$WORKTREE/wasm/native" && ./build/render_check --update --golden="$SCRIPT_DIR/golden.txt" "$MUSIC_DIR")
+
+# render_check --update keeps the raw renders next to its own build; move
+# them out before the worktree goes away
+cp "$WORKTREE/wasm/native/build/render-check/"*.pcm "$REFERENCE_DIR/"
+
+echo ""
+echo "Wrote $SCRIPT_DIR/golden.txt from $SHORT"
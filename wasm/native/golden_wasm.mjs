@@ -0,0 +1,224 @@
+/**
+ * golden.txt from shipped WASM binaries
+ *
+ * Renders the same files, settings and block hashes as render_check
+ * --update, but through the prebuilt adplug.wasm / libopenmpt.wasm of a
+ * revision instead of a native build. Used by golden.sh for revisions
+ * older than render_check itself, whose only engine build is public/.
+ *
+ * Usage: node golden_wasm.mjs <wasm_dir> <music_dir> <golden> <reference_dir> [source]
+ *   wasm_dir       Directory holding adplug.js/.wasm and libopenmpt.js/.wasm
+ *   reference_dir  Receives the raw renders (<name>.pcm) for render_check
+ *   source         Where the binaries came from, for the golden file header
+ *
+ * The libopenmpt side drives the C API directly with the settings of the
+ * adapter's mpt_load_file / mpt_compute_audio_samples (defaults, repeat 0,
+ * 1024-frame float reads).
+ */
+
+import { mkdirSync, readdirSync, readFileSync, writeFileSync } from 'node:fs';
+import { createRequire } from 'node:module';
+import path from 'node:path';
+
+// Keep in sync with render_check.cpp / formats.h
+const RENDER_SAMPLE_RATE = 44100;
+const DEFAULT_SECONDS = 10;
+const HASH_BLOCK_FRAMES = 4096;
+const MPT_BLOCK_FRAMES = 1024;
+
+const ADPLUG_EXTENSIONS = [
+  'ims', 'rol', 'vgm', 'vgz', 'cmf', 'dro', 'raw', 'laa', 'imf', 'a2m',
+  'adl', 'amd', 'bam', 'cff', 'd00', 'dfm', 'dmo', 'dtm', 'got', 'hsc',
+  'hsp', 'hsq', 'jbm', 'ksm', 'lds', 'mad', 'mdi', 'mid', 'mkj', 'msc',
+  'mtk', 'mtr', 'mus', 'pis', 'plx', 'rad', 'rix', 'sa2', 'sat', 'sci',
+  'sdb', 'sng', 'sop', 'sqx', 'xad', 'xms', 'xsm', 'ha2', 'agd',
+];
+const MPT_EXTENSIONS = [
+  'mod', 's3m', 'xm', 'it', 'mptm', 'mtm', '669', 'stm', 'med', 'okt', 'ult', 'far',
+];
+
+const require = createRequire(import.meta.url);
+
+function fileExtension(name) {
+  const dot = name.lastIndexOf('.');
+  return dot < 0 ? '' : name.slice(dot + 1).toLowerCase();
+}
+
+/**
+ * FNV-1a 64-bit, same as hashBytes() in formats.h
+ * Split into 16-bit limbs so it runs on plain numbers instead of BigInt
+ */
+function hashBytes(bytes) {
+  // 0xcbf29ce484222325
+  let h0 = 0x2325, h1 = 0x8422, h2 = 0x9ce4, h3 = 0xcbf2;
+  for (let i = 0; i < bytes.length; i++) {
+    h0 ^= bytes[i];
+    // * 0x100000001b3 = * 0x1b3 + << 40; only h0 and h1 survive the shift
+    const a0 = h0 * 0x1b3;
+    const a1 = h1 * 0x1b3 + (a0 >>> 16);
+    const a2 = h2 * 0x1b3 + (a1 >>> 16) + (h0 << 8);
+    const a3 = h3 * 0x1b3 + (a2 >>> 16) + (h1 << 8);
+    h0 = a0 & 0xffff;
+    h1 = a1 & 0xffff;
+    h2 = a2 & 0xffff;
+    h3 = a3 & 0xffff;
+  }
+  return [h3, h2, h1, h0].map((limb) => limb.toString(16).padStart(4, '0')).join('');
+}
+
+function hashBlocks(bytes, bytesPerSample) {
+  const blockBytes = HASH_BLOCK_FRAMES * 2 * bytesPerSample;
+  const hashes = [];
+  for (let offset = 0; offset < bytes.length; offset += blockBytes) {
+    hashes.push(hashBytes(bytes.subarray(offset, offset + blockBytes)));
+  }
+  return hashes;
+}
+
+/**
+ * Instantiate an Emscripten MODULARIZE build from a directory
+ * Evaluated as CommonJS, since the app's package.json makes .js files ESM
+ */
+async function loadModule(dir, name) {
+  const file = path.join(dir, `${name}.js`);
+  const module = { exports: {} };
+  const factory = new Function('module', 'exports', 'require', '__filename', '__dirname',
+    readFileSync(file, 'utf8'));
+  factory(module, module.exports, require, file, dir);
+  return module.exports({ locateFile: (f) => path.join(dir, f) });
+}
+
+function copyIn(module, bytes) {
+  const ptr = module._malloc(bytes.length);
+  module.HEAPU8.set(bytes, ptr);
+  return ptr;
+}
+
+function withString(module, text, fn) {
+  const size = Buffer.byteLength(text) + 1;
+  const ptr = module._malloc(size);
+  module.stringToUTF8(text, ptr, size);
+  try {
+    return fn(ptr);
+  } finally {
+    module._free(ptr);
+  }
+}
+
+/** renderAdPlug() of render_check.cpp */
+function renderAdPlug(adplug, name, data, banks, maxFrames) {
+  if (adplug._emu_init(RENDER_SAMPLE_RATE) !== 0) {
+    return null;
+  }
+  for (const [bankName, bank] of banks) {
+    const ptr = copyIn(adplug, bank);
+    withString(adplug, bankName, (namePtr) => adplug._emu_add_file(namePtr, ptr, bank.length));
+    adplug._free(ptr);
+  }
+  adplug._emu_set_loop_enabled(0);
+
+  const ptr = copyIn(adplug, data);
+  const loaded = withString(adplug, name, (namePtr) => adplug._emu_load_file(namePtr, ptr, data.length));
+  adplug._free(ptr);
+  if (loaded !== 0) {
+    return null;
+  }
+
+  const chunks = [];
+  let frames = 0;
+  while (frames < maxFrames) {
+    const ended = adplug._emu_compute_audio_samples();
+    const count = Math.min(adplug._emu_get_audio_buffer_length() / 4, maxFrames - frames);
+    const src = adplug._emu_get_audio_buffer();
+    chunks.push(adplug.HEAPU8.slice(src, src + count * 4));
+    frames += count;
+    if (ended || count === 0) {
+      break;
+    }
+  }
+  return { bytes: Buffer.concat(chunks), bytesPerSample: 2, frames };
+}
+
+/** renderMpt() of render_check.cpp, through the libopenmpt C API */
+function renderMpt(mpt, data, maxFrames) {
+  const ptr = copyIn(mpt, data);
+  const mod = mpt._openmpt_module_create_from_memory2(ptr, data.length, 0, 0, 0, 0, 0, 0, 0);
+  mpt._free(ptr);
+  if (!mod) {
+    return null;
+  }
+  mpt._openmpt_module_set_repeat_count(mod, 0);
+
+  const buffer = mpt._malloc(MPT_BLOCK_FRAMES * 2 * 4);
+  const chunks = [];
+  let frames = 0;
+  while (frames < maxFrames) {
+    const read = mpt._openmpt_module_read_interleaved_float_stereo(
+      mod, RENDER_SAMPLE_RATE, MPT_BLOCK_FRAMES, buffer);
+    const count = Math.min(read, maxFrames - frames);
+    chunks.push(mpt.HEAPU8.slice(buffer, buffer + count * 8));
+    frames += count;
+    if (read === 0) {
+      break;
+    }
+  }
+  mpt._free(buffer);
+  mpt._openmpt_module_destroy(mod);
+  return { bytes: Buffer.concat(chunks), bytesPerSample: 4, frames };
+}
+
+async function main() {
+  const [wasmDir, musicDir, goldenPath, referenceDir, source] = process.argv.slice(2);
+  if (!wasmDir || !musicDir || !goldenPath || !referenceDir) {
+    console.error('Usage: node golden_wasm.mjs <wasm_dir> <music_dir> <golden> <reference_dir> [source]');
+    process.exit(1);
+  }
+  const maxFrames = DEFAULT_SECONDS * RENDER_SAMPLE_RATE;
+
+  const adplug = await loadModule(wasmDir, 'adplug');
+  const mpt = await loadModule(wasmDir, 'libopenmpt');
+
+  // Byte order, as std::sort in listDirectory()
+  const names = readdirSync(musicDir).filter((name) => !name.startsWith('.'))
+    .sort((a, b) => Buffer.compare(Buffer.from(a), Buffer.from(b)));
+  const banks = names.filter((name) => fileExtension(name) === 'bnk')
+    .map((name) => [name, readFileSync(path.join(musicDir, name))]);
+
+  mkdirSync(referenceDir, { recursive: true });
+
+  const lines = [
+    `# Generated by golden_wasm.mjs from ${source || path.resolve(wasmDir)}. Do not edit by hand.`,
+    `# sample rate: ${RENDER_SAMPLE_RATE}, block frames: ${HASH_BLOCK_FRAMES}`,
+    `# seconds: ${DEFAULT_SECONDS}`,
+  ];
+  let failed = 0;
+
+  for (const name of names) {
+    const ext = fileExtension(name);
+    const engine = ADPLUG_EXTENSIONS.includes(ext) ? 'adplug'
+      : MPT_EXTENSIONS.includes(ext) ? 'libopenmpt' : null;
+    if (!engine) {
+      continue;
+    }
+
+    const data = readFileSync(path.join(musicDir, name));
+    const render = engine === 'adplug'
+      ? renderAdPlug(adplug, name, data, banks, maxFrames)
+      : renderMpt(mpt, data, maxFrames);
+    if (!render) {
+      console.error(`FAIL  ${name}: load failed`);
+      failed++;
+      continue;
+    }
+
+    const hashes = hashBlocks(render.bytes, render.bytesPerSample);
+    lines.push([name, engine, render.frames, ...hashes].join('\t'));
+    writeFileSync(path.join(referenceDir, `${name}.pcm`), render.bytes);
+  }
+
+  writeFileSync(goldenPath, `${lines.join('\n')}\n`);
+  console.log(`Wrote ${lines.length - 3} entries to ${goldenPath}`);
+  process.exit(failed ? 1 : 0);
+}
+
+main();
@@ -0,0 +1,511 @@
+/**
+ * Bit-exact golden-output regression check
+ *
+ * Renders the first N seconds of every supported file in a music
+ * directory through the adapters at fixed settings and compares a hash
+ * of each block against golden.txt. Performance work on the engines
+ * (SIMD, silence skipping, resampler changes...) must leave it green.
+ *
+ * Usage: render_check [--update] [--seconds=N] [--golden=path] [--trace=prefix] [music_dir]
+ *   --update   Rewrite the golden file from the current build
+ *   --trace    Also write the render timeline of the run as Chrome trace JSON
+ *              (<prefix>-adplug.json, <prefix>-libopenmpt.json)
+ *
+ * --update (and golden.sh) also keeps the raw reference renders in
+ * build/render-check/, which lets later runs on the same machine report
+ * the exact first differing sample instead of just the block.
+ *
+ * Before the files, CChanopl's queued-write render is checked against the
+ * same writes applied between plain update() calls.
+ *
+ * Exit status: 0 if every file matches, 1 otherwise.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include "../adplug/chanopl.h"
+#include "engines.h"
+#include "fileutil.h"
+#include "formats.h"
+
+// Fixed render settings; changing any of them invalidates golden.txt
+static const int RENDER_SAMPLE_RATE = 44100;
+static const int DEFAULT_SECONDS = 10;
+static const int HASH_BLOCK_FRAMES = 4096;
+
+static const char* const REFERENCE_DIR = "build/render-check";
+
+// Spans kept per engine with --trace (oldest dropped)
+static const int TRACE_CAPACITY = 1 << 20;
+
+struct Render {
+    std::vector<uint8_t> bytes;  // Interleaved stereo, engine-native sample format
+    int bytesPerSample;          // 2 (int16) for AdPlug, 4 (float) for libopenmpt
+    size_t frames;
+};
+
+struct Golden {
+    std::string engine;
+    size_t frames;
+    std::vector<uint64_t> hashes;
+};
+
+static std::vector<uint64_t> hashBlocks(const Render& render)
+{
+    std::vector<uint64_t> hashes;
+    size_t blockBytes = static_cast<size_t>(HASH_BLOCK_FRAMES) * 2 * render.bytesPerSample;
+    for (size_t offset = 0; offset < render.bytes.size(); offset += blockBytes) {
+        size_t size = render.bytes.size() - offset;
+        if (size > blockBytes) size = blockBytes;
+        hashes.push_back(hashBytes(render.bytes.data() + offset, size));
+    }
+    return hashes;
+}
+
+/**
+ * Render the first maxFrames frames of a file through the AdPlug adapter
+ * @param banks BNK files made available to the player
+ * @return false if the file could not be loaded
+ */
+static bool renderAdPlug(const std::string& name, const std::vector<uint8_t>& data,
+                         const std::map<std::string, std::vector<uint8_t>>& banks,
+                         size_t maxFrames, Render& render)
+{
+    render.bytesPerSample = 2;
+    render.frames = 0;
+    render.bytes.clear();
+
+    if (emu_init(RENDER_SAMPLE_RATE) != 0) {
+        return false;
+    }
+    for (const auto& bank : banks) {
+        emu_add_file(bank.first.c_str(), bank.second.data(), static_cast<int>(bank.second.size()));
+    }
+    emu_set_loop_enabled(0);
+    if (emu_load_file(name.c_str(), data.data(), static_cast<int>(data.size())) != 0) {
+        return false;
+    }
+
+    while (render.frames < maxFrames) {
+        int ended = emu_compute_audio_samples();
+        size_t frames = static_cast<size_t>(emu_get_audio_buffer_length()) / (2 * sizeof(int16_t));
+        if (frames > maxFrames - render.frames) {
+            frames = maxFrames - render.frames;
+        }
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(emu_get_audio_buffer());
+        render.bytes.insert(render.bytes.end(), src, src + frames * 2 * sizeof(int16_t));
+        render.frames += frames;
+        if (ended || frames == 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+#ifdef HAVE_LIBOPENMPT
+/**
+ * Render the first maxFrames frames of a file through the libopenmpt adapter
+ * @return false if the file could not be loaded
+ */
+static bool renderMpt(const std::string& name, const std::vector<uint8_t>& data,
+                      size_t maxFrames, Render& render)
+{
+    render.bytesPerSample = 4;
+    render.frames = 0;
+    render.bytes.clear();
+
+    if (mpt_init(RENDER_SAMPLE_RATE) != 0) {
+        return false;
+    }
+    mpt_set_repeat_count(0);
+    if (mpt_load_file(name.c_str(), data.data(), static_cast<int>(data.size())) != 0) {
+        return false;
+    }
+
+    while (render.frames < maxFrames) {
+        int ended = mpt_compute_audio_samples();
+        size_t frames = static_cast<size_t>(mpt_get_audio_buffer_frames());
+        if (frames > maxFrames - render.frames) {
+            frames = maxFrames - render.frames;
+        }
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(mpt_get_audio_buffer());
+        render.bytes.insert(render.bytes.end(), src, src + frames * 2 * sizeof(float));
+        render.frames += frames;
+        if (ended || frames == 0) {
+            break;
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+ * Parse golden.txt
+ * Format: "# comment" lines, then one "name engine frames hash..." line per file
+ */
+static bool loadGolden(const std::string& path, int& seconds,
+                       std::map<std::string, Golden>& golden)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        return false;
+    }
+
+    std::string line;
+    int c;
+    for (;;) {
+        c = fgetc(f);
+        if (c != EOF && c != '\n') {
+            line += static_cast<char>(c);
+            continue;
+        }
+
+        if (line.compare(0, 11, "# seconds: ") == 0) {
+            seconds = atoi(line.c_str() + 11);
+        } else if (!line.empty() && line[0] != '#') {
+            std::vector<std::string> fields;
+            size_t start = 0;
+            while (start <= line.size()) {
+                size_t tab = line.find('\t', start);
+                if (tab == std::string::npos) tab = line.size();
+                fields.push_back(line.substr(start, tab - start));
+                start = tab + 1;
+            }
+            if (fields.size() >= 3) {
+                Golden& entry = golden[fields[0]];
+                entry.engine = fields[1];
+                entry.frames = strtoull(fields[2].c_str(), nullptr, 10);
+                for (size_t i = 3; i < fields.size(); i++) {
+                    entry.hashes.push_back(strtoull(fields[i].c_str(), nullptr, 16));
+                }
+            }
+        }
+        line.clear();
+
+        if (c == EOF) {
+            break;
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+static bool writeGolden(const std::string& path, int seconds,
+                        const std::map<std::string, Golden>& golden)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    fprintf(f, "# Generated by render_check --update. Do not edit by hand.\n");
+    fprintf(f, "# sample rate: %d, block frames: %d\n", RENDER_SAMPLE_RATE, HASH_BLOCK_FRAMES);
+    fprintf(f, "# seconds: %d\n", seconds);
+    for (const auto& pair : golden) {
+        fprintf(f, "%s\t%s\t%zu", pair.first.c_str(), pair.second.engine.c_str(), pair.second.frames);
+        for (uint64_t hash : pair.second.hashes) {
+            fprintf(f, "\t%016llx", static_cast<unsigned long long>(hash));
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
+
+static void writeTrace(const std::string& path, const char* json)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Error: cannot write %s\n", path.c_str());
+        return;
+    }
+    fputs(json, f);
+    fclose(f);
+    printf("Wrote trace to %s\n", path.c_str());
+}
+
+/**
+ * Render a block through CChanopl::render() with queued writes, one of
+ * them past the end of the block, and the same writes applied between
+ * update() calls; both chips then play on, so a write that was dropped
+ * or applied late shows up as a differing sample
+ * @return Empty if both match, otherwise where they differ
+ */
+static std::string checkQueuedWrites()
+{
+    static const int BLOCK_FRAMES = 512;
+    static const int TAIL_FRAMES = 512;
+    static const int TOTAL_FRAMES = BLOCK_FRAMES + TAIL_FRAMES;
+
+    // One OPL2 voice: fast attack, full carrier level, keyed on
+    static const uint8_t VOICE[][2] = {
+        { 0x20, 0x01 }, { 0x23, 0x01 }, { 0x40, 0x10 }, { 0x43, 0x00 },
+        { 0x60, 0xF0 }, { 0x63, 0xF0 }, { 0x80, 0x77 }, { 0x83, 0x77 },
+        { 0xA0, 0x41 }, { 0xB0, 0x32 },
+    };
+    // Pitch change, key off, then key on again after the block
+    static const OplWrite WRITES[] = {
+        { 100, 0, 0xA0, 0x98 },
+        { 300, 0, 0xB0, 0x12 },
+        { BLOCK_FRAMES + 50, 0, 0xB0, 0x32 },
+    };
+    static const int WRITE_COUNT = sizeof(WRITES) / sizeof(WRITES[0]);
+
+    CChanopl queued(RENDER_SAMPLE_RATE);
+    CChanopl direct(RENDER_SAMPLE_RATE);
+    for (CChanopl* opl : { &queued, &direct }) {
+        opl->init();
+        for (const auto& w : VOICE) {
+            opl->write(w[0], w[1]);
+        }
+    }
+
+    std::vector<short> expected(TOTAL_FRAMES * 2);
+    std::vector<short> actual(TOTAL_FRAMES * 2);
+
+    queued.render(actual.data(), BLOCK_FRAMES, WRITES, WRITE_COUNT);
+    queued.update(&actual[BLOCK_FRAMES * 2], TAIL_FRAMES);
+
+    int pos = 0;
+    for (const OplWrite& w : WRITES) {
+        int offset = static_cast<int>(w.offset) < BLOCK_FRAMES ? static_cast<int>(w.offset) : BLOCK_FRAMES;
+        direct.update(&expected[pos * 2], offset - pos);
+        pos = offset;
+        direct.write(w.reg, w.val);
+    }
+    direct.update(&expected[pos * 2], TOTAL_FRAMES - pos);
+
+    for (int i = 0; i < TOTAL_FRAMES * 2; i++) {
+        if (actual[i] != expected[i]) {
+            char message[128];
+            snprintf(message, sizeof(message), "first differing sample at frame %d (%s)",
+                     i / 2, (i & 1) ? "right" : "left");
+            return message;
+        }
+    }
+    return "";
+}
+
+static std::string referencePath(const std::string& name)
+{
+    return std::string(REFERENCE_DIR) + "/" + name + ".pcm";
+}
+
+/**
+ * Describe where a render first diverges from its golden entry
+ * @return Human readable location of the first difference
+ */
+static std::string describeMismatch(const std::string& name, const Render& render,
+                                    const std::vector<uint64_t>& hashes,
+                                    const Golden& expected)
+{
+    size_t block = 0;
+    while (block < hashes.size() && block < expected.hashes.size() &&
+           hashes[block] == expected.hashes[block]) {
+        block++;
+    }
+
+    size_t firstFrame = block * HASH_BLOCK_FRAMES;
+    char message[256];
+
+    // Narrow it down to a single sample when a local reference render exists
+    std::vector<uint8_t> reference;
+    if (readFile(referencePath(name), reference)) {
+        size_t limit = reference.size() < render.bytes.size() ? reference.size() : render.bytes.size();
+        size_t offset = firstFrame * 2 * render.bytesPerSample;
+        while (offset < limit && reference[offset] == render.bytes[offset]) {
+            offset++;
+        }
+        if (offset < limit) {
+            size_t sample = offset / render.bytesPerSample;
+            snprintf(message, sizeof(message), "block %zu, first differing sample at frame %zu (%s)",
+                     block, sample / 2, (sample & 1) ? "right" : "left");
+            return message;
+        }
+    }
+
+    if (render.frames != expected.frames) {
+        snprintf(message, sizeof(message), "block %zu, length %zu frames (expected %zu)",
+                 block, render.frames, expected.frames);
+    } else {
+        snprintf(message, sizeof(message), "block %zu (frames %zu-%zu)",
+                 block, firstFrame, firstFrame + HASH_BLOCK_FRAMES - 1);
+    }
+    return message;
+}
+
+int main(int argc, char** argv)
+{
+    std::string musicDir = "../../public";
+    std::string goldenPath = "golden.txt";
+    std::string tracePrefix;
+    bool update = false;
+    int seconds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--update") {
+            update = true;
+        } else if (arg.compare(0, 10, "--seconds=") == 0) {
+            seconds = atoi(arg.c_str() + 10);
+        } else if (arg.compare(0, 9, "--golden=") == 0) {
+            goldenPath = arg.substr(9);
+        } else if (arg.compare(0, 8, "--trace=") == 0) {
+            tracePrefix = arg.substr(8);
+        } else if (arg == "--help" || arg == "-h") {
+            printf("Usage: %s [--update] [--seconds=N] [--golden=path] [--trace=prefix] [music_dir]\n", argv[0]);
+            return 0;
+        } else {
+            musicDir = arg;
+        }
+    }
+
+    std::map<std::string, Golden> golden;
+    int goldenSeconds = DEFAULT_SECONDS;
+    if (!loadGolden(goldenPath, goldenSeconds, golden) && !update) {
+        fprintf(stderr, "Error: cannot read %s (run with --update to create it)\n", goldenPath.c_str());
+        return 1;
+    }
+    if (seconds <= 0) {
+        seconds = goldenSeconds;
+    } else if (!update && seconds != goldenSeconds) {
+        fprintf(stderr, "Error: --seconds=%d does not match golden file (%d)\n", seconds, goldenSeconds);
+        return 1;
+    }
+    size_t maxFrames = static_cast<size_t>(seconds) * RENDER_SAMPLE_RATE;
+
+    // Every BNK is offered to every AdPlug file, as the player picks its own
+    std::vector<std::string> names = listDirectory(musicDir);
+    std::map<std::string, std::vector<uint8_t>> banks;
+    for (const std::string& name : names) {
+        if (fileExtension(name) == "bnk") {
+            readFile(musicDir + "/" + name, banks[name]);
+        }
+    }
+
+    if (update) {
+        mkdir("build", 0755);
+        mkdir(REFERENCE_DIR, 0755);
+        golden.clear();
+    }
+
+    if (!tracePrefix.empty()) {
+        emu_trace_enable(TRACE_CAPACITY);
+#ifdef HAVE_LIBOPENMPT
+        mpt_trace_enable(TRACE_CAPACITY);
+#endif
+    }
+
+    int checked = 0;
+    int failed = 0;
+    std::map<std::string, bool> seen;
+
+    std::string queuedMismatch = checkQueuedWrites();
+    if (!queuedMismatch.empty()) {
+        printf("FAIL  CChanopl::render: %s\n", queuedMismatch.c_str());
+        failed++;
+    }
+
+    for (const std::string& name : names) {
+        Engine engine = engineFor(name);
+        if (engine == ENGINE_NONE) {
+            continue;
+        }
+#ifndef HAVE_LIBOPENMPT
+        if (engine == ENGINE_MPT) {
+            continue;
+        }
+#endif
+
+        seen[name] = true;
+
+        std::vector<uint8_t> data;
+        if (!readFile(musicDir + "/" + name, data) || data.empty()) {
+            fprintf(stderr, "FAIL  %s: cannot read file\n", name.c_str());
+            failed++;
+            continue;
+        }
+
+        Render render;
+        bool loaded;
+#ifdef HAVE_LIBOPENMPT
+        if (engine == ENGINE_MPT) {
+            loaded = renderMpt(name, data, maxFrames, render);
+        } else
+#endif
+        {
+            loaded = renderAdPlug(name, data, banks, maxFrames, render);
+        }
+        if (!loaded) {
+            fprintf(stderr, "FAIL  %s: load failed\n", name.c_str());
+            failed++;
+            continue;
+        }
+
+        std::vector<uint64_t> hashes = hashBlocks(render);
+        checked++;
+
+        if (update) {
+            golden[name] = { engineName(engine), render.frames, hashes };
+            FILE* f = fopen(referencePath(name).c_str(), "wb");
+            if (f) {
+                fwrite(render.bytes.data(), 1, render.bytes.size(), f);
+                fclose(f);
+            }
+            continue;
+        }
+
+        auto it = golden.find(name);
+        if (it == golden.end()) {
+            printf("FAIL  %s: no golden entry\n", name.c_str());
+            failed++;
+        } else if (it->second.frames != render.frames || it->second.hashes != hashes) {
+            printf("FAIL  %s: %s\n", name.c_str(),
+                   describeMismatch(name, render, hashes, it->second).c_str());
+            failed++;
+        }
+    }
+
+    if (!tracePrefix.empty()) {
+        writeTrace(tracePrefix + "-adplug.json", emu_trace_export());
+#ifdef HAVE_LIBOPENMPT
+        writeTrace(tracePrefix + "-libopenmpt.json", mpt_trace_export());
+#endif
+    }
+
+    emu_teardown();
+#ifdef HAVE_LIBOPENMPT
+    mpt_teardown();
+#endif
+
+    if (update) {
+        if (!writeGolden(goldenPath, seconds, golden)) {
+            fprintf(stderr, "Error: cannot write %s\n", goldenPath.c_str());
+            return 1;
+        }
+        printf("Wrote %zu entries to %s\n", golden.size(), goldenPath.c_str());
+        return failed ? 1 : 0;
+    }
+
+    // Golden entries whose file disappeared are failures too
+    for (const auto& pair : golden) {
+#ifndef HAVE_LIBOPENMPT
+        if (pair.second.engine == "libopenmpt") {
+            continue;
+        }
+#endif
+        if (!seen.count(pair.first)) {
+            printf("FAIL  %s: file missing\n", pair.first.c_str());
+            failed++;
+        }
+    }
+
+    printf("%d checked, %d failed\n", checked, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,665 @@
+/**
+ * Native render daemon streaming PCM to thin clients
+ *
+ * Serves songs from a music directory over a minimal HTTP/1.1 interface,
+ * on a Unix socket (default) or a loopback TCP port, for clients that
+ * cannot synthesize in real time themselves:
+ *
+ *   GET /list                 Supported files in the music directory
+ *   GET /render/<file>?...    16-bit stereo audio, rendered on demand
+ *       rate=44100            Output sample rate (8000-192000)
+ *       format=wav|pcm        WAV header (default) or raw little-endian PCM
+ *       seconds=0             Length cap, 0 = until the song ends
+ *       loop=0                1 = restart at the end until the cap (or forever)
+ *
+ * Audio is sent with chunked transfer encoding while it renders; the
+ * client's read rate is the only pacing. Finite renders are also written
+ * to a disk cache keyed by (content hash, engine, settings), and later
+ * requests for the same key are served from the file with a
+ * Content-Length.
+ *
+ * The adapters keep their playback state in globals, so each stream gets
+ * its own forked worker process instead of a thread; --jobs caps how many
+ * run at once.
+ *
+ * Usage: render_daemon [--socket=path | --port=N] [--cache=dir] [--jobs=N] [music_dir]
+ *   curl --unix-socket render_daemon.sock http://x/render/SONG.IMS -o song.wav
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "engines.h"
+#include "fileutil.h"
+#include "formats.h"
+#include "wav.h"
+
+static const int DEFAULT_SAMPLE_RATE = 44100;
+static const int MIN_SAMPLE_RATE = 8000;
+static const int MAX_SAMPLE_RATE = 192000;
+
+// Finite renders are cut here, like the browser export
+static const int MAX_SECONDS = 30 * 60;
+
+static const size_t MAX_REQUEST_BYTES = 8192;
+static const size_t FILE_CHUNK_BYTES = 64 * 1024;
+
+// Bump when engine output changes, so stale cache entries are not served
+static const uint64_t CACHE_VERSION = 1;
+
+// Header size field for streams of unknown length
+static const uint32_t STREAM_WAV_DATA_BYTES = 0xFFFFFFFFu - 36;
+
+struct Settings {
+    int sampleRate;
+    bool wav;
+    int seconds;    // 0 = until the song ends
+    bool loop;
+};
+
+static std::string g_musicDir = "../../public";
+static std::string g_cacheDir = "build/render-cache";
+static std::map<std::string, std::vector<uint8_t>> g_banks;  // Offered to every AdPlug song
+
+/**
+ * Write the whole buffer, retrying short writes
+ * @return false once the client is gone
+ */
+static bool sendAll(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool sendChunk(int fd, const void* data, size_t size)
+{
+    if (size == 0) {
+        return true;  // A zero-size chunk would end the response
+    }
+    char head[32];
+    int headLen = snprintf(head, sizeof(head), "%zx\r\n", size);
+    return sendAll(fd, head, headLen) && sendAll(fd, data, size) && sendAll(fd, "\r\n", 2);
+}
+
+static void sendResponse(int fd, int status, const char* reason, const std::string& body)
+{
+    char head[256];
+    int headLen = snprintf(head, sizeof(head),
+                           "HTTP/1.1 %d %s\r\nContent-Type: text/plain; charset=utf-8\r\n"
+                           "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                           status, reason, body.size());
+    if (sendAll(fd, head, headLen)) {
+        sendAll(fd, body.data(), body.size());
+    }
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static std::string urlDecode(const std::string& s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+            out += static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+            i += 2;
+        } else if (s[i] == '+') {
+            out += ' ';
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+static std::map<std::string, std::string> parseQuery(const std::string& query)
+{
+    std::map<std::string, std::string> params;
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t amp = query.find('&', start);
+        if (amp == std::string::npos) amp = query.size();
+        std::string pair = query.substr(start, amp - start);
+        size_t eq = pair.find('=');
+        if (eq != std::string::npos) {
+            params[urlDecode(pair.substr(0, eq))] = urlDecode(pair.substr(eq + 1));
+        } else if (!pair.empty()) {
+            params[urlDecode(pair)] = "";
+        }
+        start = amp + 1;
+    }
+    return params;
+}
+
+/**
+ * Parse and validate the render query
+ * @return Error message, or empty on success
+ */
+static std::string parseSettings(const std::map<std::string, std::string>& params, Settings& settings)
+{
+    settings.sampleRate = DEFAULT_SAMPLE_RATE;
+    settings.wav = true;
+    settings.seconds = 0;
+    settings.loop = false;
+
+    for (const auto& param : params) {
+        const std::string& key = param.first;
+        const std::string& value = param.second;
+        if (key == "rate") {
+            settings.sampleRate = atoi(value.c_str());
+            if (settings.sampleRate < MIN_SAMPLE_RATE || settings.sampleRate > MAX_SAMPLE_RATE) {
+                return "rate out of range";
+            }
+        } else if (key == "format") {
+            if (value != "wav" && value != "pcm") {
+                return "format must be wav or pcm";
+            }
+            settings.wav = value == "wav";
+        } else if (key == "seconds") {
+            settings.seconds = atoi(value.c_str());
+            if (settings.seconds < 0 || settings.seconds > MAX_SECONDS) {
+                return "seconds out of range";
+            }
+        } else if (key == "loop") {
+            settings.loop = value == "1";
+        } else {
+            return "unknown parameter: " + key;
+        }
+    }
+    return "";
+}
+
+// Song files are plain names inside the music directory
+static bool isSafeName(const std::string& name)
+{
+    return !name.empty() && name[0] != '.' && name.find('/') == std::string::npos &&
+           name.find('\\') == std::string::npos;
+}
+
+/**
+ * Cache file for a render: content hash (song and, for AdPlug, the banks),
+ * engine and every setting that changes the samples
+ */
+static std::string cachePath(Engine engine, const std::string& name, const std::vector<uint8_t>& data,
+                             const Settings& settings)
+{
+    // The extension picks the loader, so it is part of the content
+    std::string ext = fileExtension(name);
+    uint64_t hash = hashBytes(reinterpret_cast<const uint8_t*>(ext.data()), ext.size());
+    hash = hashBytes(data.data(), data.size(), hash);
+    if (engine == ENGINE_ADPLUG) {
+        for (const auto& bank : g_banks) {
+            hash = hashBytes(reinterpret_cast<const uint8_t*>(bank.first.data()), bank.first.size(), hash);
+            hash = hashBytes(bank.second.data(), bank.second.size(), hash);
+        }
+    }
+
+    char key[160];
+    snprintf(key, sizeof(key), "%016llx-%s-%d-%d-%d-v%llu",
+             static_cast<unsigned long long>(hash), engineName(engine), settings.sampleRate,
+             settings.seconds, settings.loop ? 1 : 0, static_cast<unsigned long long>(CACHE_VERSION));
+    return g_cacheDir + "/" + key + ".pcm";
+}
+
+static void sendAudioHead(int fd, const Settings& settings, bool chunked, uint64_t dataBytes)
+{
+    char head[256];
+    int headLen;
+    const char* type = settings.wav ? "audio/wav" : "audio/L16";
+    if (chunked) {
+        headLen = snprintf(head, sizeof(head),
+                           "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n"
+                           "Connection: close\r\n\r\n", type);
+    } else {
+        uint64_t length = dataBytes + (settings.wav ? WAV_HEADER_SIZE : 0);
+        headLen = snprintf(head, sizeof(head),
+                           "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %llu\r\n"
+                           "Connection: close\r\n\r\n", type, static_cast<unsigned long long>(length));
+    }
+    sendAll(fd, head, headLen);
+}
+
+/**
+ * Serve a finished render from the cache
+ * @return false if there is no cache entry
+ */
+static bool serveCached(int fd, const std::string& path, const Settings& settings)
+{
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(file, &st) != 0) {
+        close(file);
+        return false;
+    }
+
+    uint64_t dataBytes = static_cast<uint64_t>(st.st_size);
+    sendAudioHead(fd, settings, false, dataBytes);
+    if (settings.wav) {
+        uint8_t header[WAV_HEADER_SIZE];
+        writeWavHeader(header, settings.sampleRate, 2, 16, static_cast<uint32_t>(dataBytes));
+        sendAll(fd, header, sizeof(header));
+    }
+
+    std::vector<uint8_t> buf(FILE_CHUNK_BYTES);
+    for (;;) {
+        ssize_t n = read(file, buf.data(), buf.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || !sendAll(fd, buf.data(), static_cast<size_t>(n))) {
+            break;
+        }
+    }
+    close(file);
+    return true;
+}
+
+static inline int16_t floatToPcm(float v)
+{
+    float scaled = v * 32767.0f;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return static_cast<int16_t>(scaled);
+}
+
+/**
+ * Load the song into its engine
+ * @return false if the engine rejected the file
+ */
+static bool openSong(Engine engine, const std::string& name, const std::vector<uint8_t>& data,
+                     const Settings& settings)
+{
+#ifdef HAVE_LIBOPENMPT
+    if (engine == ENGINE_MPT) {
+        if (mpt_init(settings.sampleRate) != 0) {
+            return false;
+        }
+        mpt_set_repeat_count(settings.loop ? -1 : 0);
+        return mpt_load_file(name.c_str(), data.data(), static_cast<int>(data.size())) == 0;
+    }
+#endif
+    if (engine != ENGINE_ADPLUG || emu_init(settings.sampleRate) != 0) {
+        return false;
+    }
+    for (const auto& bank : g_banks) {
+        emu_add_file(bank.first.c_str(), bank.second.data(), static_cast<int>(bank.second.size()));
+    }
+    emu_set_loop_enabled(settings.loop ? 1 : 0);
+    return emu_load_file(name.c_str(), data.data(), static_cast<int>(data.size())) == 0;
+}
+
+/**
+ * Render the next block as interleaved int16 stereo
+ * @return false at the end of the song
+ */
+static bool renderBlock(Engine engine, bool loop, std::vector<int16_t>& out)
+{
+#ifdef HAVE_LIBOPENMPT
+    if (engine == ENGINE_MPT) {
+        // Repeat count -1 makes libopenmpt loop by itself
+        int ended = mpt_compute_audio_samples();
+        int frames = mpt_get_audio_buffer_frames();
+        const float* src = mpt_get_audio_buffer();
+        out.resize(static_cast<size_t>(frames) * 2);
+        for (size_t i = 0; i < out.size(); i++) {
+            out[i] = floatToPcm(src[i]);
+        }
+        return !ended && frames > 0;
+    }
+#else
+    (void)engine;
+#endif
+    int ended = emu_compute_audio_samples();
+    size_t samples = static_cast<size_t>(emu_get_audio_buffer_length()) / sizeof(int16_t);
+    const int16_t* src = emu_get_audio_buffer();
+    out.assign(src, src + samples);
+    if (ended && loop) {
+        // Same as the browser player: restart at the end of the song
+        emu_rewind();
+        return true;
+    }
+    return !ended;
+}
+
+/**
+ * Render a song, streaming it to the client and (for finite renders)
+ * into the cache
+ */
+static void serveRender(int fd, Engine engine, const std::string& name,
+                        const std::vector<uint8_t>& data, const Settings& settings,
+                        const std::string& cacheFile)
+{
+    if (!openSong(engine, name, data, settings)) {
+        sendResponse(fd, 422, "Unprocessable Entity", "load failed\n");
+        return;
+    }
+
+    // Looping without a cap never ends and is not cached
+    bool endless = settings.loop && settings.seconds == 0;
+    uint64_t maxFrames = static_cast<uint64_t>(settings.seconds > 0 ? settings.seconds : MAX_SECONDS) *
+                         settings.sampleRate;
+
+    std::string tmpPath = cacheFile + "." + std::to_string(getpid()) + ".tmp";
+    FILE* cache = endless ? nullptr : fopen(tmpPath.c_str(), "wb");
+
+    sendAudioHead(fd, settings, true, 0);
+    bool clientOk = true;
+    if (settings.wav) {
+        uint8_t header[WAV_HEADER_SIZE];
+        writeWavHeader(header, settings.sampleRate, 2, 16, STREAM_WAV_DATA_BYTES);
+        clientOk = sendChunk(fd, header, sizeof(header));
+    }
+
+    std::vector<int16_t> block;
+    uint64_t frames = 0;
+    bool playing = true;
+    while (clientOk && playing && (endless || frames < maxFrames)) {
+        playing = renderBlock(engine, settings.loop, block);
+        size_t blockFrames = block.size() / 2;
+        if (!endless && frames + blockFrames > maxFrames) {
+            blockFrames = static_cast<size_t>(maxFrames - frames);
+        }
+        size_t bytes = blockFrames * 2 * sizeof(int16_t);
+        frames += blockFrames;
+
+        // PCM on the wire is little-endian, as is every host we build for
+        clientOk = sendChunk(fd, block.data(), bytes);
+        if (cache && fwrite(block.data(), 1, bytes, cache) != bytes) {
+            fclose(cache);
+            cache = nullptr;
+            unlink(tmpPath.c_str());
+        }
+    }
+    if (clientOk) {
+        sendAll(fd, "0\r\n\r\n", 5);
+    }
+
+    // Only a render that ran to its end is a valid cache entry
+    if (cache) {
+        bool complete = fclose(cache) == 0 && clientOk;
+        if (!complete || rename(tmpPath.c_str(), cacheFile.c_str()) != 0) {
+            unlink(tmpPath.c_str());
+        }
+    }
+
+    printf("[%d] %s %s: %llu frames%s\n", static_cast<int>(getpid()), engineName(engine), name.c_str(),
+           static_cast<unsigned long long>(frames), clientOk ? "" : " (client closed)");
+}
+
+static void serveList(int fd)
+{
+    std::string body;
+    for (const std::string& name : listDirectory(g_musicDir)) {
+        Engine engine = engineFor(name);
+#ifndef HAVE_LIBOPENMPT
+        if (engine == ENGINE_MPT) {
+            continue;
+        }
+#endif
+        if (engine != ENGINE_NONE) {
+            body += name + "\t" + engineName(engine) + "\n";
+        }
+    }
+    sendResponse(fd, 200, "OK", body);
+}
+
+/**
+ * Read the request head and dispatch it (runs in the worker process)
+ */
+static void handleClient(int fd)
+{
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        if (request.size() > MAX_REQUEST_BYTES) {
+            sendResponse(fd, 431, "Request Header Fields Too Large", "request too large\n");
+            return;
+        }
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    // Request line: METHOD SP target SP version
+    size_t lineEnd = request.find("\r\n");
+    std::string line = request.substr(0, lineEnd);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) {
+        sendResponse(fd, 400, "Bad Request", "malformed request line\n");
+        return;
+    }
+    std::string method = line.substr(0, sp1);
+    std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    if (method != "GET") {
+        sendResponse(fd, 405, "Method Not Allowed", "only GET is supported\n");
+        return;
+    }
+
+    size_t question = target.find('?');
+    std::string path = urlDecode(target.substr(0, question));
+    std::string query = question != std::string::npos ? target.substr(question + 1) : "";
+
+    if (path == "/list") {
+        serveList(fd);
+        return;
+    }
+    if (path.compare(0, 8, "/render/") != 0) {
+        sendResponse(fd, 404, "Not Found", "unknown path\n");
+        return;
+    }
+
+    std::string name = path.substr(8);
+    Settings settings;
+    std::string error = parseSettings(parseQuery(query), settings);
+    if (!error.empty()) {
+        sendResponse(fd, 400, "Bad Request", error + "\n");
+        return;
+    }
+    if (!isSafeName(name)) {
+        sendResponse(fd, 400, "Bad Request", "invalid file name\n");
+        return;
+    }
+
+    Engine engine = engineFor(name);
+#ifndef HAVE_LIBOPENMPT
+    if (engine == ENGINE_MPT) {
+        engine = ENGINE_NONE;
+    }
+#endif
+    if (engine == ENGINE_NONE) {
+        sendResponse(fd, 415, "Unsupported Media Type", "unsupported format\n");
+        return;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(g_musicDir + "/" + name, data) || data.empty()) {
+        sendResponse(fd, 404, "Not Found", "no such file\n");
+        return;
+    }
+
+    std::string cacheFile = cachePath(engine, name, data, settings);
+    if (serveCached(fd, cacheFile, settings)) {
+        printf("[%d] %s %s: cached\n", static_cast<int>(getpid()), engineName(engine), name.c_str());
+        return;
+    }
+    serveRender(fd, engine, name, data, settings, cacheFile);
+}
+
+/**
+ * Create the listening socket
+ * @return File descriptor, or -1 on failure
+ */
+static int listenOn(const std::string& socketPath, int port)
+{
+    int fd;
+    if (port > 0) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        // Loopback only: there is no authentication
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) {
+            close(fd);
+            return -1;
+        }
+        strcpy(addr.sun_path, socketPath.c_str());
+        unlink(socketPath.c_str());
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv)
+{
+    std::string socketPath = "render_daemon.sock";
+    int port = 0;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--socket=") == 0) {
+            socketPath = arg.substr(9);
+        } else if (arg.compare(0, 7, "--port=") == 0) {
+            port = atoi(arg.c_str() + 7);
+        } else if (arg.compare(0, 8, "--cache=") == 0) {
+            g_cacheDir = arg.substr(8);
+        } else if (arg.compare(0, 7, "--jobs=") == 0) {
+            jobs = atol(arg.c_str() + 7);
+        } else if (arg == "--help" || arg == "-h") {
+            printf("Usage: %s [--socket=path | --port=N] [--cache=dir] [--jobs=N] [music_dir]\n", argv[0]);
+            return 0;
+        } else {
+            g_musicDir = arg;
+        }
+    }
+    if (jobs < 1) jobs = 1;
+
+    // Banks are loaded once and shared with the workers copy-on-write
+    for (const std::string& name : listDirectory(g_musicDir)) {
+        if (fileExtension(name) == "bnk") {
+            readFile(g_musicDir + "/" + name, g_banks[name]);
+        }
+    }
+
+    mkdir("build", 0755);
+    mkdir(g_cacheDir.c_str(), 0755);
+
+    int listenFd = listenOn(socketPath, port);
+    if (listenFd < 0) {
+        fprintf(stderr, "Error: cannot listen on %s: %s\n",
+                port > 0 ? ("127.0.0.1:" + std::to_string(port)).c_str() : socketPath.c_str(),
+                strerror(errno));
+        return 1;
+    }
+
+    // A client hanging up mid-stream must not kill the worker
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    printf("Serving %s on %s (%ld jobs, cache %s)\n", g_musicDir.c_str(),
+           port > 0 ? ("127.0.0.1:" + std::to_string(port)).c_str() : socketPath.c_str(),
+           jobs, g_cacheDir.c_str());
+
+    long active = 0;
+    for (;;) {
+        // Reap finished workers; block while all job slots are busy
+        while (active > 0 && waitpid(-1, nullptr, active >= jobs ? 0 : WNOHANG) > 0) {
+            active--;
+        }
+
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listenFd);
+            handleClient(client);
+            close(client);
+            _exit(0);
+        }
+        if (pid < 0) {
+            perror("fork");
+            sendResponse(client, 503, "Service Unavailable", "no worker available\n");
+        } else {
+            active++;
+        }
+        close(client);
+    }
+
+    close(listenFd);
+    return 1;
+}